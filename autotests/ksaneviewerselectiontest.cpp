@@ -0,0 +1,113 @@
+/* ============================================================
+*
+* This file is part of the KDE project
+*
+* Date        : 2026-10-19
+* Description : Test of the viewer selections that are cropped in software.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) version 3, or any
+* later version accepted by the membership of KDE e.V. (or its
+* successor approved by the membership of KDE e.V.), which shall
+* act as a proxy defined in Section 6 of version 3 of the license.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* ============================================================ */
+
+// A device without the tl-x/tl-y/br-x/br-y options can not scan a selection. The
+// widget keeps the selections in the viewer and crops them from the whole scan area,
+// so the viewer must keep every selection and report it relative to the whole image.
+
+#include "ksaneviewer.h"
+
+#include <QTest>
+#include <QSignalSpy>
+#include <QImage>
+#include <QPainter>
+
+using namespace KSaneIface;
+
+class KSaneViewerSelectionTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+    void activeSelection();
+    void foundSelections();
+
+private:
+    QImage m_img;
+};
+
+void KSaneViewerSelectionTest::init()
+{
+    // a white preview of the whole scan area with two dark photos
+    m_img = QImage(800, 600, QImage::Format_RGB32);
+    m_img.fill(Qt::white);
+    QPainter painter(&m_img);
+    painter.fillRect(QRect(80, 60, 240, 180), Qt::black);
+    painter.fillRect(QRect(400, 300, 320, 240), Qt::darkGray);
+}
+
+void KSaneViewerSelectionTest::activeSelection()
+{
+    KSaneViewer viewer(&m_img);
+    float tl_x, tl_y, br_x, br_y;
+
+    // without a selection the whole area is scanned
+    QCOMPARE(viewer.selListSize(), 0);
+    viewer.selectionAt(0, tl_x, tl_y, br_x, br_y);
+    QCOMPARE(tl_x, 0.0f);
+    QCOMPARE(tl_y, 0.0f);
+    QCOMPARE(br_x, 1.0f);
+    QCOMPARE(br_y, 1.0f);
+
+    viewer.setSelection(0.1, 0.2, 0.5, 0.7);
+    QCOMPARE(viewer.selListSize(), 1);
+    QVERIFY(viewer.selectionAt(0, tl_x, tl_y, br_x, br_y));
+    QVERIFY(qAbs(tl_x - 0.1f) < 0.01f);
+    QVERIFY(qAbs(tl_y - 0.2f) < 0.01f);
+    QVERIFY(qAbs(br_x - 0.5f) < 0.01f);
+    QVERIFY(qAbs(br_y - 0.7f) < 0.01f);
+}
+
+void KSaneViewerSelectionTest::foundSelections()
+{
+    KSaneViewer viewer(&m_img);
+    QSignalSpy spy(&viewer, SIGNAL(selectionsChanged()));
+
+    viewer.findSelections();
+    QVERIFY(spy.wait(10000));
+    QCOMPARE(viewer.selListSize(), 2);
+
+    const QRectF photos[2] = {
+        QRectF(80.0 / 800, 60.0 / 600, 240.0 / 800, 180.0 / 600),
+        QRectF(400.0 / 800, 300.0 / 600, 320.0 / 800, 240.0 / 600)
+    };
+    for (int i = 0; i < 2; i++) {
+        float tl_x, tl_y, br_x, br_y;
+        QVERIFY(viewer.selectionAt(i, tl_x, tl_y, br_x, br_y));
+        const QRectF sel(QPointF(tl_x, tl_y), QPointF(br_x, br_y));
+
+        // the selections are found in any order
+        const QRectF &photo = photos[sel.contains(photos[0].center()) ? 0 : 1];
+        QVERIFY(qAbs(sel.left() - photo.left()) < 0.03);
+        QVERIFY(qAbs(sel.top() - photo.top()) < 0.03);
+        QVERIFY(qAbs(sel.right() - photo.right()) < 0.03);
+        QVERIFY(qAbs(sel.bottom() - photo.bottom()) < 0.03);
+    }
+}
+
+QTEST_MAIN(KSaneViewerSelectionTest)
+
+#include "ksaneviewerselectiontest.moc"
@@ -65,6 +65,11 @@ KSaneAuth::KSaneAuth() : d(new Private) {}
 
 KSaneAuth::~KSaneAuth()
 {
+    s_mutex.lock();
+    if (s_instance == this) {
+        s_instance = nullptr;
+    }
+    s_mutex.unlock();
     d->authList.clear();
     delete d;
 }
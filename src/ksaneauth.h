@@ -28,6 +28,8 @@
 #ifndef KSANE_AUTH_H
 #define KSANE_AUTH_H
 
+#include "ksanecore_export.h"
+
 // Qt includes
 #include <QString>
 
@@ -41,7 +43,7 @@ extern "C"
 namespace KSaneIface
 {
 
-class KSaneAuth
+class KSANECORE_EXPORT KSaneAuth
 {
 public:
     static KSaneAuth *getInstance();
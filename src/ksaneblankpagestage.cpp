@@ -0,0 +1,235 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#include "ksaneblankpagestage.h"
+
+#include "ksanecore.h"
+
+#include <QVariant>
+#include <QDebug>
+
+#include <limits.h>
+#include <math.h>
+
+namespace KSaneIface
+{
+
+/** Add the gray levels of the pixels left to right - 1 of a row to the statistics. */
+static void addRow(const uchar *line, int format, int left, int right, int inkLevel,
+                   qint64 &ink, quint64 &sum, quint64 &sumSquares)
+{
+    int gray;
+    switch (format) {
+    case KSaneCore::FormatBlackWhite:
+        for (int x = left; x < right; x++) {
+            // 1 = black
+            gray = (line[x >> 3] & (0x80 >> (x & 7))) ? 0 : 255;
+            ink += (gray < inkLevel);
+            sum += gray;
+            sumSquares += gray * gray;
+        }
+        break;
+    case KSaneCore::FormatGrayScale8:
+        for (int x = left; x < right; x++) {
+            gray = line[x];
+            ink += (gray < inkLevel);
+            sum += gray;
+            sumSquares += gray * gray;
+        }
+        break;
+    case KSaneCore::FormatGrayScale16: {
+        const quint16 *line16 = reinterpret_cast<const quint16 *>(line);
+        for (int x = left; x < right; x++) {
+            gray = line16[x] >> 8;
+            ink += (gray < inkLevel);
+            sum += gray;
+            sumSquares += gray * gray;
+        }
+        break;
+    }
+    case KSaneCore::FormatRGB_8_C:
+        for (int x = left; x < right; x++) {
+            const uchar *pixel = line + (x * 3);
+            // the same weights as qGray()
+            gray = (pixel[0] * 11 + pixel[1] * 16 + pixel[2] * 5) >> 5;
+            ink += (gray < inkLevel);
+            sum += gray;
+            sumSquares += gray * gray;
+        }
+        break;
+    case KSaneCore::FormatRGB_16_C: {
+        const quint16 *line16 = reinterpret_cast<const quint16 *>(line);
+        for (int x = left; x < right; x++) {
+            const quint16 *pixel = line16 + (x * 3);
+            gray = (pixel[0] * 11 + pixel[1] * 16 + pixel[2] * 5) >> 13;
+            ink += (gray < inkLevel);
+            sum += gray;
+            sumSquares += gray * gray;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+struct KSaneBlankPageStage::Private {
+    int        inkLevel;
+    double     maxCoverage;
+    double     maxDeviation;
+    QMarginsF  margins;
+    bool       drop;
+
+    // the state of the page that is read
+    int        format;
+    int        left;
+    int        right;
+    int        top;
+    int        bottom;
+    qint64     maxInk;
+    qint64     pixels;
+    qint64     ink;
+    quint64    sum;
+    quint64    sumSquares;
+    bool       notBlank;
+};
+
+KSaneBlankPageStage::KSaneBlankPageStage()
+    : d(new Private)
+{
+    d->inkLevel     = 160;
+    d->maxCoverage  = 0.2;
+    d->maxDeviation = 12.0;
+    d->margins      = QMarginsF(0.05, 0.05, 0.05, 0.05);
+    d->drop         = false;
+    d->format       = KSaneCore::FormatNone;
+    d->left         = 0;
+    d->right        = 0;
+    d->top          = 0;
+    d->bottom       = 0;
+    d->maxInk       = -1;
+    d->pixels       = 0;
+    d->ink          = 0;
+    d->sum          = 0;
+    d->sumSquares   = 0;
+    d->notBlank     = false;
+}
+
+KSaneBlankPageStage::~KSaneBlankPageStage()
+{
+    delete d;
+}
+
+void KSaneBlankPageStage::setInkLevel(int inkLevel)
+{
+    d->inkLevel = qBound(0, inkLevel, 256);
+}
+
+void KSaneBlankPageStage::setMaxInkCoverage(double percent)
+{
+    d->maxCoverage = qMax(0.0, percent);
+}
+
+void KSaneBlankPageStage::setMaxGrayDeviation(double deviation)
+{
+    d->maxDeviation = qMax(0.0, deviation);
+}
+
+void KSaneBlankPageStage::setMargins(const QMarginsF &margins)
+{
+    d->margins = margins;
+}
+
+void KSaneBlankPageStage::setDropBlankPages(bool drop)
+{
+    d->drop = drop;
+}
+
+void KSaneBlankPageStage::beginPage(const KSanePage &page)
+{
+    d->format = page.format;
+    d->left   = qBound(0, (int)(page.width * d->margins.left()), page.width);
+    d->right  = qBound(d->left, (int)(page.width * (1.0 - d->margins.right())), page.width);
+    if (page.height > 0) {
+        d->top    = qBound(0, (int)(page.height * d->margins.top()), page.height);
+        d->bottom = qBound(d->top, (int)(page.height * (1.0 - d->margins.bottom())), page.height);
+        d->maxInk = (qint64)((double)(d->right - d->left) * (d->bottom - d->top) * d->maxCoverage / 100.0);
+    } else {
+        // a hand scanner does not know where the page ends
+        d->top    = 0;
+        d->bottom = INT_MAX;
+        d->maxInk = -1;
+    }
+    d->pixels     = 0;
+    d->ink        = 0;
+    d->sum        = 0;
+    d->sumSquares = 0;
+    d->notBlank   = false;
+}
+
+void KSaneBlankPageStage::processRows(char *rows, int firstRow, int rowCount, int bytesPerLine)
+{
+    if (d->notBlank) {
+        return;
+    }
+
+    int first = qMax(firstRow, d->top);
+    int last  = qMin(firstRow + rowCount, d->bottom);
+    for (int row = first; row < last; row++) {
+        const uchar *line = reinterpret_cast<const uchar *>(rows) + ((qint64)(row - firstRow) * bytesPerLine);
+        addRow(line, d->format, d->left, d->right, d->inkLevel, d->ink, d->sum, d->sumSquares);
+        d->pixels += d->right - d->left;
+
+        if ((d->maxInk >= 0) && (d->ink > d->maxInk)) {
+            // the page has more ink than a blank page can have, so the rest is not needed
+            d->notBlank = true;
+            return;
+        }
+    }
+}
+
+void KSaneBlankPageStage::endPage(KSanePage &page)
+{
+    if (d->pixels == 0) {
+        // nothing was measured
+        page.properties.insert(QStringLiteral("blank"), false);
+        return;
+    }
+
+    double coverage  = (d->ink * 100.0) / d->pixels;
+    double mean      = (double)d->sum / d->pixels;
+    double deviation = sqrt(qMax(0.0, ((double)d->sumSquares / d->pixels) - (mean * mean)));
+    bool blank = !d->notBlank && (coverage <= d->maxCoverage) && (deviation <= d->maxDeviation);
+
+    page.properties.insert(QStringLiteral("blank"), blank);
+    page.properties.insert(QStringLiteral("inkCoverage"), coverage);
+    page.properties.insert(QStringLiteral("grayDeviation"), deviation);
+    if (blank && d->drop) {
+        qDebug() << "Dropping blank page: ink coverage" << coverage << "% gray deviation" << deviation;
+        page.dropped = true;
+    }
+}
+
+}  // NameSpace KSaneIface
@@ -0,0 +1,87 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#ifndef KSANE_BLANK_PAGE_STAGE_H
+#define KSANE_BLANK_PAGE_STAGE_H
+
+#include "ksanecore_export.h"
+#include "ksanepipeline.h"
+
+#include <QMarginsF>
+
+namespace KSaneIface
+{
+
+/**
+ * This row stage detects blank pages, for example the empty backsides of a duplex scan,
+ * while the rows are read. A page is blank when the share of ink pixels and the standard
+ * deviation of the gray levels inside the margins are below the limits. As soon as a page
+ * has too much ink, the remaining rows are not looked at.
+ *
+ * The result is stored in the properties "blank" (bool), "inkCoverage" (percent) and
+ * "grayDeviation" of the page. The last two are measured over the rows that were looked
+ * at. A blank page can also be dropped, so that it is neither delivered with imageReady()
+ * nor processed by the page stages.
+ *
+ * The settings must not be changed during a scan.
+ */
+class KSANECORE_EXPORT KSaneBlankPageStage : public KSaneRowStage
+{
+public:
+    KSaneBlankPageStage();
+    ~KSaneBlankPageStage();
+
+    /** A pixel with a gray level (0-255) below inkLevel is ink. The default is 160. */
+    void setInkLevel(int inkLevel);
+
+    /** @param percent is the largest share of ink pixels of a blank page. The default is 0.2 %. */
+    void setMaxInkCoverage(double percent);
+
+    /** @param deviation is the largest standard deviation of the gray levels (0-255) of a
+     * blank page. It detects faint content that is lighter than the ink level.
+     * The default is 12. */
+    void setMaxGrayDeviation(double deviation);
+
+    /** Ignore the borders of the page, where the edges of the paper and punch holes are.
+     * @param margins are relative to the page size (0.0 -> 1.0). The default is 5 % on every side.
+     * The vertical margins are not used if the line count is not known in advance. */
+    void setMargins(const QMarginsF &margins);
+
+    /** @param drop is true to drop the blank pages instead of only marking them (default). */
+    void setDropBlankPages(bool drop);
+
+    void beginPage(const KSanePage &page) override;
+    void processRows(char *rows, int firstRow, int rowCount, int bytesPerLine) override;
+    void endPage(KSanePage &page) override;
+
+private:
+    Q_DISABLE_COPY(KSaneBlankPageStage)
+    struct Private;
+    Private *const d;
+};
+
+}  // NameSpace KSaneIface
+
+#endif // KSANE_BLANK_PAGE_STAGE_H
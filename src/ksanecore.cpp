@@ -0,0 +1,274 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#include "ksanecore.h"
+#include "ksanecore_p.h"
+#include "ksanehandlepool.h"
+#include "ksaneoptionvalue.h"
+
+#include <unistd.h>
+
+#include <QMutex>
+#include <QDebug>
+
+namespace KSaneIface
+{
+static int     s_saneUsers = 0;
+static QMutex  s_saneMutex;
+
+QMutex *KSaneCore::globalMutex()
+{
+    return &s_saneMutex;
+}
+
+bool KSaneCore::initSane()
+{
+    SANE_Int    version;
+    SANE_Status status = SANE_STATUS_GOOD;
+
+    s_saneMutex.lock();
+    s_saneUsers++;
+    if (s_saneUsers == 1) {
+        // only call sane init for the first user
+        status = sane_init(&version, &KSaneAuth::authorization);
+        if (status != SANE_STATUS_GOOD) {
+            qDebug() << "libksane: sane_init() failed("
+                     << sane_strstatus(status) << ")";
+        }
+    }
+    s_saneMutex.unlock();
+    return status == SANE_STATUS_GOOD;
+}
+
+void KSaneCore::exitSane()
+{
+    s_saneMutex.lock();
+    s_saneUsers--;
+    if (s_saneUsers <= 0) {
+        // only delete the singletons and call sane_exit for the last user
+        delete KSaneAuth::getInstance();
+        KSaneHandlePool::deleteInstanceLocked();
+        sane_exit();
+        s_saneUsers = 0;
+    }
+    s_saneMutex.unlock();
+}
+
+KSaneCore::KSaneCore(QObject *parent)
+    : QObject(parent), d(new KSaneCorePrivate(this))
+{
+    initSane();
+}
+
+KSaneCore::~KSaneCore()
+{
+    if (d->m_host) {
+        // a scan host is not waited for, it is killed if it is scanning
+        d->closeHandle();
+    }
+    while (!closeDevice()) {
+        usleep(1000);
+    }
+    delete d;
+    exitSane();
+}
+
+void KSaneCore::setDeviceAuth(const QString &deviceName, const QString &username, const QString &password)
+{
+    d->m_auth->setDeviceAuth(deviceName, username, password);
+}
+
+void KSaneCore::setIsolated(bool isolated, int timeoutMsec)
+{
+    d->m_isolated = isolated;
+    d->m_hostTimeout = timeoutMsec;
+}
+
+void KSaneCore::setScanStallTimeout(int stallMsec, int escalationMsec)
+{
+    d->m_session->setStallTimeout(stallMsec, escalationMsec);
+}
+
+bool KSaneCore::openDevice(const QString &deviceName)
+{
+    SANE_Status status;
+    QVector<const SANE_Option_Descriptor *> descriptors;
+
+    if (d->isOpen()) {
+        // this KSaneCore already has an open device
+        return false;
+    }
+    if (deviceName.isEmpty()) {
+        return false;
+    }
+
+    if (d->m_isolated) {
+        d->m_host = new KSaneScanHostClient(d);
+        d->m_host->setTimeout(d->m_hostTimeout);
+        d->m_host->setPipeline(d->m_pipeline);
+        connect(d->m_host, SIGNAL(pageDone(int)), d, SLOT(hostPageDone(int)));
+        if (!d->m_host->open(deviceName)) {
+            d->m_auth->clearDeviceAuth(deviceName);
+            delete d->m_host;
+            d->m_host = nullptr;
+            return false;
+        }
+        d->m_devName = deviceName;
+        return true;
+    }
+
+    // the credentials set with setDeviceAuth() are used by the authorization callback
+    status = KSaneHandlePool::getInstance()->open(deviceName, &d->m_saneHandle, descriptors);
+    if (status != SANE_STATUS_GOOD) {
+        qDebug() << "sane_open(\"" << deviceName << "\", &handle) failed! status = " << sane_strstatus(status);
+        d->m_auth->clearDeviceAuth(deviceName);
+        d->m_saneHandle = nullptr;
+        return false;
+    }
+    d->m_devName = deviceName;
+
+    d->m_session->createThread(d->m_saneHandle, &d->m_scanData);
+    return true;
+}
+
+bool KSaneCore::closeDevice()
+{
+    if (!d->isOpen()) {
+        return true;
+    }
+
+    if (d->m_session->pipelineWait()) {
+        cancelScan();
+    }
+
+    if (d->m_host && d->m_host->isScanning()) {
+        d->m_host->cancelScan();
+        d->m_closeDevicePending = true;
+        return false;
+    }
+
+    if (d->m_session->isRunning()) {
+        if (!d->m_session->thread()->abandoned()) {
+            d->m_session->thread()->cancelScan();
+            d->m_closeDevicePending = true;
+            return false;
+        }
+        // the queued abandoned() can not be waited for, the caller may block the event loop
+        d->m_session->releaseThread();
+        d->m_progressTmr.stop();
+        emit(scanDone(KSaneCore::ErrorStalled, KSaneScanSession::abandonedMessage()));
+    }
+
+    d->closeHandle();
+    return true;
+}
+
+QString KSaneCore::deviceName() const
+{
+    return d->m_devName;
+}
+
+QStringList KSaneCore::optionNames() const
+{
+    if (d->m_host) {
+        return d->m_host->optionNames();
+    }
+    return KSaneOptionValue::optionNames(d->m_saneHandle);
+}
+
+bool KSaneCore::getOptionValue(const QString &name, QString &value)
+{
+    if (d->m_host) {
+        return d->m_host->getOptionValue(name, value);
+    }
+    return KSaneOptionValue::getValue(d->m_saneHandle, name, value);
+}
+
+bool KSaneCore::setOptionValue(const QString &name, const QString &value)
+{
+    if (isScanning()) {
+        return false;
+    }
+    if (d->m_host) {
+        return d->m_host->setOptionValue(name, value);
+    }
+    return KSaneOptionValue::setValue(d->m_saneHandle, name, value);
+}
+
+void KSaneCore::startScan()
+{
+    if (!d->isOpen() || isScanning()) {
+        return;
+    }
+    if (d->m_host) {
+        if (!d->startHostScan()) {
+            return;
+        }
+    } else if (d->m_session->thread()) {
+        d->m_session->thread()->start();
+    } else {
+        // the scan thread was abandoned
+        return;
+    }
+    d->m_progressTmr.start();
+}
+
+void KSaneCore::cancelScan()
+{
+    if (d->m_session->cancelPipelineWait()) {
+        // the next page of the batch is not started yet
+        if (d->m_host) {
+            d->m_host->endScan();
+        } else {
+            sane_cancel(d->m_saneHandle);
+        }
+        emit(scanDone(KSaneCore::NoError, QStringLiteral("")));
+        return;
+    }
+
+    if (d->m_host) {
+        d->m_host->cancelScan();
+    } else if (d->m_session->isRunning()) {
+        d->m_session->thread()->cancelScan();
+    }
+}
+
+bool KSaneCore::isScanning() const
+{
+    if (d->m_session->pipelineWait()) {
+        return true;
+    }
+    if (d->m_host) {
+        return d->m_host->isScanning();
+    }
+    return d->m_session->isRunning();
+}
+
+KSanePipeline *KSaneCore::pipeline() const
+{
+    return d->m_pipeline;
+}
+
+}  // NameSpace KSaneIface
@@ -0,0 +1,189 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#ifndef KSANE_CORE_H
+#define KSANE_CORE_H
+
+#include "ksanecore_export.h"
+
+#include <QObject>
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+class QMutex;
+
+namespace KSaneIface
+{
+
+class KSaneCorePrivate;
+class KSanePipeline;
+
+/**
+ * This class provides scanning without any widgets. It owns the SANE handle and the
+ * scan thread and delivers the scanned data and the progress with signals. It only
+ * depends on QtCore, so it can be used in services that run without a display.
+ */
+class KSANECORE_EXPORT KSaneCore : public QObject
+{
+    Q_OBJECT
+    friend class KSaneCorePrivate;
+
+public:
+    /** This enumeration describes the type of the returned data.
+     * The values are the same as in KSaneWidget::ImageFormat. */
+    typedef enum {
+        FormatBlackWhite,   /**< One bit per pixel 1 = black 0 = white */
+        FormatGrayScale8,   /**< Grayscale with one byte per pixel 0 = black 255 = white */
+        FormatGrayScale16,  /**< Grayscale with two bytes per pixel.
+                             * The byte order is the one provided by libsane. */
+        FormatRGB_8_C,      /**< Every pixel consists of three colors in the order Red,
+                             * Green and Blue, with one byte per color (no alpha channel). */
+        FormatRGB_16_C,     /**< Every pixel consists of three colors in the order Red,
+                             * Green and Blue, with two bytes per color (no alpha channel).
+                             * The byte order is the one provided by libsane. */
+        FormatBMP,          /**< The image data  is returned as a BMP. */
+        FormatNone = 0xFFFF /**< This enumeration value should never be returned to the user */
+    } ImageFormat;
+
+    /** The values are the same as in KSaneWidget::ScanStatus. */
+    typedef enum {
+        NoError,            /**< The scanning was finished successfully.*/
+        ErrorCannotSegment, /**< Not used by KSaneCore. */
+        ErrorGeneral,       /**< The error string should contain an error message. */
+        Information,        /**< There is some information to the user. */
+        ErrorStalled        /**< The scanner stopped sending data and the scan was cancelled. */
+    } ScanStatus;
+
+    explicit KSaneCore(QObject *parent = nullptr);
+    ~KSaneCore();
+
+    /** Call sane_init() for the first user in the process. Every call must be paired
+     * with a call to exitSane(). KSaneCore and KSaneWidget do this themselves.
+     * @return false if sane_init() failed. */
+    static bool initSane();
+
+    /** Call sane_exit() when the last user of SANE is gone. */
+    static void exitSane();
+
+    /** sane_init(), sane_exit(), sane_get_devices(), sane_open() and sane_close() are
+     * not thread safe. Everybody calling them must hold this mutex, so that several
+     * devices can be used from different threads. */
+    static QMutex *globalMutex();
+
+    /** Set the user name and password that are used if the device requires authentication.
+     * This must be called before openDevice(). */
+    void setDeviceAuth(const QString &deviceName, const QString &username, const QString &password);
+
+    /** Open the device in a separate scan host process. A backend that crashes or hangs
+     * then only stops that process: the scan is finished with ErrorGeneral and the device
+     * must be opened again. The data is passed through shared memory and the row stages of
+     * the pipeline get the rows while the page is read. Devices that send the colors in
+     * three separate frames are not supported in this mode.
+     * This must be called before openDevice().
+     * @note Only KSaneCore has an isolation mode. KSaneWidget always uses the device
+     * in the process of the application.
+     * @param isolated enables the scan host (disabled by default).
+     * @param timeoutMsec is the time after which a host that does not answer or does not
+     * deliver scan data is killed. */
+    void setIsolated(bool isolated, int timeoutMsec = 60000);
+
+    /** Cancel a scan when the scanner does not send data for stallMsec. The scan is first
+     * cancelled after the running read, then sane_cancel() is called from a watchdog thread,
+     * and at last the scan is abandoned. Each step waits escalationMsec. The scan is
+     * finished with ErrorStalled. An abandoned device can not be used any more and must be
+     * closed. An isolated device uses the timeout of setIsolated() instead.
+     * @param stallMsec is the stall timeout or 0 to disable the watchdog (default).
+     * @param escalationMsec is the time between the cancel steps. */
+    void setScanStallTimeout(int stallMsec, int escalationMsec = 10000);
+
+    /** @param deviceName is the libsane device name for the scanner to open.
+     * @return 'true' if the device was opened. */
+    bool openDevice(const QString &deviceName);
+
+    /** Close the device. A running scan is cancelled and the device is closed when
+     * the scan thread has stopped.
+     * @return 'false' if the close is pending because of a running scan. */
+    bool closeDevice();
+
+    /** @return the name of the open device or an empty string. */
+    QString deviceName() const;
+
+    /** @return the names of the options that have a value. */
+    QStringList optionNames() const;
+
+    /** Read the value of an option. Boolean, integer, fixed point and string options
+     * with a single value are supported.
+     * @return 'false' if the option is not active or not supported. */
+    bool getOptionValue(const QString &name, QString &value);
+
+    /** Write the value of an option. The supported options are the same as for getOptionValue().
+     * @return 'false' if the value could not be written. */
+    bool setOptionValue(const QString &name, const QString &value);
+
+    /** Start a scan with the current options. Batch scanning with a document feeder or
+     * the "wait-for-button" option continues until there are no more documents. */
+    void startScan();
+
+    /** Cancel the running scan. */
+    void cancelScan();
+
+    bool isScanning() const;
+
+    /** @return the pipeline that post-processes the scanned pages. Every page that is
+     * delivered with imageReady() is also queued in the pipeline. When the pipeline is full,
+     * a batch scan waits with the next page until a page is processed. */
+    KSanePipeline *pipeline() const;
+
+Q_SIGNALS:
+    /**
+     * This signal is emitted for every scanned page that is not dropped by a row stage
+     * of the pipeline.
+     * @param data is the scanned data. It is only valid during the signal.
+     * @param width is the width of the image in pixels.
+     * @param height is the height of the image in pixels.
+     * @param bytes_per_line is the number of bytes used per line.
+     * @param format is the KSaneCore::ImageFormat of the data.
+     */
+    void imageReady(QByteArray &data, int width, int height,
+                    int bytes_per_line, int format);
+
+    /** This signal is emitted regularly during a scan.
+     * @param percent is the percentage of the page that is scanned. */
+    void scanProgress(int percent);
+
+    /** This signal is emitted when the scan is finished, also after a cancel.
+     * @param status is a KSaneCore::ScanStatus.
+     * @param strStatus is the untranslated error or information string. The
+     * application should show its own message for the status. */
+    void scanDone(int status, const QString &strStatus);
+
+private:
+    KSaneCorePrivate *const d;
+};
+
+}  // NameSpace KSaneIface
+
+#endif // KSANE_CORE_H
@@ -0,0 +1,236 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#include "ksanecore_p.h"
+#include "ksanehandlepool.h"
+
+#include <QMutex>
+#include <QVarLengthArray>
+#include <QDebug>
+
+namespace KSaneIface
+{
+
+KSaneCorePrivate::KSaneCorePrivate(KSaneCore *parent)
+    : q(parent),
+      m_saneHandle(nullptr),
+      m_auth(KSaneAuth::getInstance()),
+      m_host(nullptr),
+      m_isolated(false),
+      m_hostTimeout(60000),
+      m_closeDevicePending(false)
+{
+    m_progressTmr.setSingleShot(false);
+    m_progressTmr.setInterval(300);
+    connect(&m_progressTmr, SIGNAL(timeout()), this, SLOT(updateProgress()));
+
+    m_pipeline = new KSanePipeline(this);
+    m_session = new KSaneScanSession(m_pipeline, this);
+    connect(m_session, SIGNAL(pageDone()), this, SLOT(scanThreadDone()));
+    connect(m_session, SIGNAL(abandoned()), this, SLOT(scanAbandoned()));
+    connect(m_session, SIGNAL(nextPage()), this, SLOT(startNextPage()));
+}
+
+bool KSaneCorePrivate::isBatchScan()
+{
+    QString source;
+    QString waitForButton;
+    q->getOptionValue(QStringLiteral(SANE_NAME_SCAN_SOURCE), source);
+    // (Note: No translation)
+    q->getOptionValue(QStringLiteral("wait-for-button"), waitForButton);
+    return KSaneScanSession::isBatchScan(source, waitForButton);
+}
+
+bool KSaneCorePrivate::isOpen() const
+{
+    return (m_saneHandle != nullptr) || (m_host != nullptr);
+}
+
+void KSaneCorePrivate::closeHandle()
+{
+    m_progressTmr.stop();
+    m_auth->clearDeviceAuth(m_devName);
+    if (m_host) {
+        m_host->close();
+        delete m_host;
+        m_host = nullptr;
+    }
+    if (m_saneHandle) {
+        if (m_session->handleAbandoned()) {
+            // the backend still blocks in the abandoned scan thread
+            qDebug() << "The handle of" << m_devName << "is not closed";
+        } else {
+            KSaneHandlePool::getInstance()->release(m_devName, m_saneHandle);
+        }
+        m_saneHandle = nullptr;
+    }
+    m_session->clear();
+    m_scanData.clear();
+    m_devName.clear();
+    m_closeDevicePending = false;
+}
+
+void KSaneCorePrivate::scanAbandoned()
+{
+    m_progressTmr.stop();
+    if (m_closeDevicePending) {
+        closeHandle();
+    }
+    emit(q->scanDone(KSaneCore::ErrorStalled, KSaneScanSession::abandonedMessage()));
+}
+
+void KSaneCorePrivate::updateProgress()
+{
+    if (m_host != nullptr) {
+        emit(q->scanProgress(m_host->scanProgress()));
+        return;
+    }
+    if (m_session->thread() == nullptr) {
+        return;
+    }
+    emit(q->scanProgress(m_session->thread()->scanProgress()));
+}
+
+void KSaneCorePrivate::scanThreadDone()
+{
+    m_progressTmr.stop();
+    updateProgress();
+
+    if (m_closeDevicePending) {
+        closeHandle();
+        emit(q->scanDone(KSaneCore::NoError, QStringLiteral("")));
+        return;
+    }
+
+    KSaneScanThread *thread = m_session->thread();
+    if (thread->frameStatus() == KSaneScanThread::READ_READY) {
+        deliverPage(m_scanData, thread->saneParameters());
+
+        if (isBatchScan()) {
+            m_session->requestNextPage();
+            return;
+        }
+
+        sane_cancel(m_saneHandle);
+        emit(q->scanDone(KSaneCore::NoError, QStringLiteral("")));
+        return;
+    }
+
+    sane_cancel(m_saneHandle);
+    if (thread->stalled()) {
+        emit(q->scanDone(KSaneCore::ErrorStalled, KSaneScanSession::stalledMessage()));
+        return;
+    }
+    emitScanDone(thread->saneStatus());
+}
+
+void KSaneCorePrivate::hostPageDone(int status)
+{
+    m_progressTmr.stop();
+    updateProgress();
+
+    if (m_closeDevicePending) {
+        closeHandle();
+        emit(q->scanDone(KSaneCore::NoError, QStringLiteral("")));
+        return;
+    }
+
+    if (!m_host->errorString().isEmpty()) {
+        // the host process is gone
+        emit(q->scanDone(m_host->stalled() ? KSaneCore::ErrorStalled : KSaneCore::ErrorGeneral,
+                         m_host->errorString()));
+        return;
+    }
+
+    if (status == SANE_STATUS_GOOD) {
+        deliverPage(m_host->pageData(), m_host->pageParameters());
+
+        if (isBatchScan()) {
+            m_session->requestNextPage();
+            return;
+        }
+        m_host->endScan();
+        emit(q->scanDone(KSaneCore::NoError, QStringLiteral("")));
+        return;
+    }
+
+    m_host->endScan();
+    emitScanDone((SANE_Status)status);
+}
+
+void KSaneCorePrivate::deliverPage(QByteArray &data, const SANE_Parameters &params)
+{
+    KSanePage page = KSaneScanSession::pageFromParameters(params, data.size());
+    QString resolution;
+    if (q->getOptionValue(QStringLiteral(SANE_NAME_SCAN_RESOLUTION), resolution)) {
+        page.dpi = (int)resolution.toFloat();
+    }
+
+    page.data = data;
+    m_pipeline->endRows(page);
+
+    if (!page.dropped) {
+        emit(q->imageReady(data, page.width, page.height, page.bytesPerLine, page.format));
+    }
+    m_pipeline->queuePage(page);
+}
+
+void KSaneCorePrivate::startNextPage()
+{
+    if (m_host) {
+        if (!startHostScan()) {
+            return;
+        }
+    } else if (m_session->thread()) {
+        m_session->thread()->start();
+    } else {
+        return;
+    }
+    m_progressTmr.start();
+}
+
+bool KSaneCorePrivate::startHostScan()
+{
+    if (!m_host->isAlive()) {
+        // the host was stopped, the device must be closed and opened again
+        QString message = m_host->errorString();
+        if (message.isEmpty()) {
+            message = QStringLiteral("The scan host is not running");
+        }
+        emit(q->scanDone(KSaneCore::ErrorGeneral, message));
+        return false;
+    }
+    m_host->startScan();
+    return true;
+}
+
+void KSaneCorePrivate::emitScanDone(SANE_Status status)
+{
+    QString message;
+    const KSaneCore::ScanStatus scanStatus = KSaneScanSession::scanStatus(status, message);
+    emit(q->scanDone(scanStatus, message));
+}
+
+}  // NameSpace KSaneIface
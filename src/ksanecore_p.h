@@ -0,0 +1,95 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#ifndef KSANE_CORE_P_H
+#define KSANE_CORE_P_H
+
+#include "ksanecore.h"
+
+// Sane includes
+extern "C"
+{
+#include <sane/saneopts.h>
+#include <sane/sane.h>
+}
+
+#include <QObject>
+#include <QTimer>
+#include <QByteArray>
+
+#include "ksanescanthread.h"
+#include "ksanescanhostclient.h"
+#include "ksanescansession.h"
+#include "ksaneauth.h"
+#include "ksanepipeline.h"
+
+namespace KSaneIface
+{
+
+class KSaneCorePrivate : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit KSaneCorePrivate(KSaneCore *parent);
+
+    bool isBatchScan();
+    bool isOpen() const;
+    void closeHandle();
+    /** Emit scanDone() for a scan that ended with status. */
+    void emitScanDone(SANE_Status status);
+    /** Emit imageReady() unless a row stage drops the page and queue it in the pipeline.
+     * The row stages have seen the rows while the page was read. */
+    void deliverPage(QByteArray &data, const SANE_Parameters &params);
+    /** Start a page in the scan host. scanDone() is emitted if the host is gone.
+     * @return true if the page was started. */
+    bool startHostScan();
+
+public Q_SLOTS:
+    void scanThreadDone();
+    void hostPageDone(int status);
+    void scanAbandoned();
+    void updateProgress();
+    /** Start the next page of a batch scan. */
+    void startNextPage();
+
+public:
+    KSaneCore          *q;
+    SANE_Handle         m_saneHandle;
+    QString             m_devName;
+    KSaneAuth          *m_auth;
+    KSaneScanHostClient *m_host;
+    bool                m_isolated;
+    int                 m_hostTimeout;
+    QByteArray          m_scanData;
+    QTimer              m_progressTmr;
+    bool                m_closeDevicePending;
+    KSanePipeline      *m_pipeline;
+    KSaneScanSession   *m_session;
+};
+
+}  // NameSpace KSaneIface
+
+#endif // KSANE_CORE_P_H
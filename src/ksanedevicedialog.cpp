@@ -98,6 +98,8 @@ KSaneDeviceDialog::KSaneDeviceDialog(QWidget *parent)
     m_findDevThread = FindSaneDevicesThread::getInstance();
 
     connect(m_findDevThread, &FindSaneDevicesThread::finished, this, &KSaneDeviceDialog::updateDevicesList);
+    connect(m_findDevThread, &FindSaneDevicesThread::listChanged, this, &KSaneDeviceDialog::updateDevicesList);
+    connect(m_findDevThread, &FindSaneDevicesThread::deviceFound, this, &KSaneDeviceDialog::updateDevicesList);
 
     reloadDevicesList();
 }
@@ -120,6 +122,12 @@ void KSaneDeviceDialog::reloadDevicesList()
     if (!m_findDevThread->isRunning()) {
         m_findDevThread->start();
     }
+
+    // show the cached list while the list is checked
+    if (m_findDevThread->isCachedList()) {
+        updateDevicesList();
+        m_btnReloadDevices->setEnabled(false);
+    }
 }
 
 void KSaneDeviceDialog::setAvailable(bool isAvailable)
@@ -185,11 +193,12 @@ void KSaneDeviceDialog::updateDevicesList()
 
     m_btnLayout->addStretch();
 
-    if (list.size() == 1) {
+    // a cached device might not be available any more and more devices can be found
+    if ((list.size() == 1) && !m_findDevThread->isCachedList() && !m_findDevThread->isRunning()) {
         m_btnOk->animateClick(); // 2014-01-21: why animated?
     }
 
-    m_btnReloadDevices->setEnabled(true);
+    m_btnReloadDevices->setEnabled(!m_findDevThread->isRunning());
 }
 
 }
@@ -0,0 +1,86 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+// This helper enumerates the SANE devices for FindSaneDevicesThread. It runs in its
+// own process, so that a backend that hangs in sane_get_devices() can be killed.
+//
+// Every device is written as one line with the tab separated fields
+// name, vendor, model and type.
+
+// Sane includes
+extern "C"
+{
+#include <sane/saneopts.h>
+#include <sane/sane.h>
+}
+
+#include <stdio.h>
+
+static void writeField(const char *field, char separator)
+{
+    if (field != nullptr) {
+        for (const char *c = field; *c != 0; c++) {
+            // the separators are not allowed in the fields
+            fputc(((*c == '\t') || (*c == '\n')) ? ' ' : *c, stdout);
+        }
+    }
+    fputc(separator, stdout);
+}
+
+int main()
+{
+    SANE_Int            version;
+    SANE_Device const **devList;
+    SANE_Status         status;
+
+    status = sane_init(&version, nullptr);
+    if (status != SANE_STATUS_GOOD) {
+        fprintf(stderr, "sane_init() failed: %s\n", sane_strstatus(status));
+        return 1;
+    }
+
+    status = sane_get_devices(&devList, SANE_FALSE);
+    if (status != SANE_STATUS_GOOD) {
+        fprintf(stderr, "sane_get_devices() failed: %s\n", sane_strstatus(status));
+        sane_exit();
+        return 1;
+    }
+
+    for (int i = 0; devList[i] != nullptr; i++) {
+        writeField(devList[i]->name, '\t');
+        writeField(devList[i]->vendor, '\t');
+        writeField(devList[i]->model, '\t');
+        writeField(devList[i]->type, '\n');
+        // the reader keeps the devices it got before a timeout
+        fflush(stdout);
+    }
+
+    // an empty line marks the complete list
+    fputc('\n', stdout);
+    fflush(stdout);
+
+    sane_exit();
+    return 0;
+}
@@ -0,0 +1,180 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#include "ksanedevicemanager.h"
+
+#include "ksanecore.h"
+#include "ksaneauth.h"
+
+#include <QMap>
+#include <QSet>
+#include <QDebug>
+
+namespace KSaneIface
+{
+
+struct KSaneDeviceManager::Private {
+    QMap<QString, KSaneCore *> devices;
+    QSet<KSaneCore *>          scanning;
+};
+
+KSaneDeviceManager::KSaneDeviceManager(QObject *parent)
+    : QObject(parent), d(new Private)
+{
+    // keep SANE initialized while the manager exists, also when no device is open
+    KSaneCore::initSane();
+}
+
+KSaneDeviceManager::~KSaneDeviceManager()
+{
+    closeAllDevices();
+    delete d;
+    KSaneCore::exitSane();
+}
+
+void KSaneDeviceManager::setDeviceAuth(const QString &deviceName, const QString &username, const QString &password)
+{
+    KSaneAuth::getInstance()->setDeviceAuth(deviceName, username, password);
+}
+
+bool KSaneDeviceManager::openDevice(const QString &deviceName)
+{
+    if (d->devices.contains(deviceName)) {
+        return true;
+    }
+
+    KSaneCore *core = new KSaneCore(this);
+    if (!core->openDevice(deviceName)) {
+        delete core;
+        return false;
+    }
+
+    connect(core, SIGNAL(imageReady(QByteArray&,int,int,int,int)),
+            this, SLOT(deviceImageReady(QByteArray&,int,int,int,int)));
+    connect(core, SIGNAL(scanProgress(int)), this, SLOT(deviceScanProgress(int)));
+    connect(core, SIGNAL(scanDone(int,QString)), this, SLOT(deviceScanDone(int,QString)));
+
+    d->devices.insert(deviceName, core);
+    return true;
+}
+
+void KSaneDeviceManager::closeDevice(const QString &deviceName)
+{
+    KSaneCore *core = d->devices.take(deviceName);
+    if (core == nullptr) {
+        return;
+    }
+    disconnect(core, nullptr, this, nullptr);
+    // a running scan is cancelled and the handle is closed when the scan thread
+    // has stopped. This can be called from a slot connected to the core.
+    core->closeDevice();
+    core->deleteLater();
+
+    if (d->scanning.remove(core) && d->scanning.isEmpty()) {
+        emit allScansDone();
+    }
+}
+
+void KSaneDeviceManager::closeAllDevices()
+{
+    const QStringList names = d->devices.keys();
+    for (int i = 0; i < names.size(); ++i) {
+        closeDevice(names.at(i));
+    }
+}
+
+QStringList KSaneDeviceManager::deviceNames() const
+{
+    return d->devices.keys();
+}
+
+KSaneCore *KSaneDeviceManager::device(const QString &deviceName) const
+{
+    return d->devices.value(deviceName, nullptr);
+}
+
+void KSaneDeviceManager::startScan(const QString &deviceName)
+{
+    KSaneCore *core = d->devices.value(deviceName, nullptr);
+    if ((core == nullptr) || core->isScanning()) {
+        return;
+    }
+    d->scanning.insert(core);
+    core->startScan();
+}
+
+void KSaneDeviceManager::startAllScans()
+{
+    QMap<QString, KSaneCore *>::const_iterator it;
+    for (it = d->devices.constBegin(); it != d->devices.constEnd(); ++it) {
+        startScan(it.key());
+    }
+}
+
+void KSaneDeviceManager::cancelAllScans()
+{
+    QMap<QString, KSaneCore *>::const_iterator it;
+    for (it = d->devices.constBegin(); it != d->devices.constEnd(); ++it) {
+        it.value()->cancelScan();
+    }
+}
+
+bool KSaneDeviceManager::isScanning() const
+{
+    return !d->scanning.isEmpty();
+}
+
+void KSaneDeviceManager::deviceImageReady(QByteArray &data, int width, int height, int bytes_per_line, int format)
+{
+    KSaneCore *core = qobject_cast<KSaneCore *>(sender());
+    if (core == nullptr) {
+        return;
+    }
+    emit imageReady(core->deviceName(), data, width, height, bytes_per_line, format);
+}
+
+void KSaneDeviceManager::deviceScanProgress(int percent)
+{
+    KSaneCore *core = qobject_cast<KSaneCore *>(sender());
+    if (core == nullptr) {
+        return;
+    }
+    emit scanProgress(core->deviceName(), percent);
+}
+
+void KSaneDeviceManager::deviceScanDone(int status, const QString &strStatus)
+{
+    KSaneCore *core = qobject_cast<KSaneCore *>(sender());
+    if (core == nullptr) {
+        return;
+    }
+    emit scanDone(core->deviceName(), status, strStatus);
+
+    if (d->scanning.remove(core) && d->scanning.isEmpty()) {
+        emit allScansDone();
+    }
+}
+
+}  // NameSpace KSaneIface
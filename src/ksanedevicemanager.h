@@ -0,0 +1,114 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#ifndef KSANE_DEVICE_MANAGER_H
+#define KSANE_DEVICE_MANAGER_H
+
+#include "ksanecore_export.h"
+
+#include <QObject>
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+namespace KSaneIface
+{
+
+class KSaneCore;
+
+/**
+ * This class drives several devices at the same time. Every device is opened with its
+ * own KSaneCore, so every device has its own scan thread, data buffer and progress.
+ * The signals of the devices are forwarded with the name of the device.
+ */
+class KSANECORE_EXPORT KSaneDeviceManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit KSaneDeviceManager(QObject *parent = nullptr);
+    ~KSaneDeviceManager();
+
+    /** Set the user name and password that are used if the device requires authentication.
+     * This must be called before openDevice(). */
+    void setDeviceAuth(const QString &deviceName, const QString &username, const QString &password);
+
+    /** Open a device. Opening a device that is already open does nothing.
+     * @return 'true' if the device is open. */
+    bool openDevice(const QString &deviceName);
+
+    /** Close a device. A running scan of the device is cancelled and the device is
+     * closed as soon as the scan thread has stopped. */
+    void closeDevice(const QString &deviceName);
+
+    /** Close all devices. */
+    void closeAllDevices();
+
+    /** @return the names of the open devices. */
+    QStringList deviceNames() const;
+
+    /** @return the core of an open device, for example to set the options,
+     * or nullptr if the device is not open. */
+    KSaneCore *device(const QString &deviceName) const;
+
+    /** Start a scan on one device. */
+    void startScan(const QString &deviceName);
+
+    /** Start a scan on every open device that is not scanning. */
+    void startAllScans();
+
+    /** Cancel the scans of all devices. */
+    void cancelAllScans();
+
+    /** @return true if any device is scanning. */
+    bool isScanning() const;
+
+Q_SIGNALS:
+    /** See KSaneCore::imageReady() */
+    void imageReady(const QString &deviceName, QByteArray &data, int width, int height,
+                    int bytes_per_line, int format);
+
+    /** See KSaneCore::scanProgress() */
+    void scanProgress(const QString &deviceName, int percent);
+
+    /** See KSaneCore::scanDone() */
+    void scanDone(const QString &deviceName, int status, const QString &strStatus);
+
+    /** This signal is emitted when the last running scan is done. */
+    void allScansDone();
+
+private Q_SLOTS:
+    void deviceImageReady(QByteArray &data, int width, int height, int bytes_per_line, int format);
+    void deviceScanProgress(int percent);
+    void deviceScanDone(int status, const QString &strStatus);
+
+private:
+    struct Private;
+    Private *const d;
+};
+
+}  // NameSpace KSaneIface
+
+#endif // KSANE_DEVICE_MANAGER_H
@@ -29,6 +29,10 @@
 
 #include "ksanefinddevicesthread.h"
 
+#include "ksanecore.h"
+#include "ksanehotplugmonitor.h"
+#include "ksanehandlepool.h"
+
 // #include "ksanewidget_p.h"
 
 // Sane includes
@@ -39,11 +43,50 @@ extern "C"
 }
 
 #include <QMutex>
+#include <QMutexLocker>
+#include <QStandardPaths>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QFile>
+#include <QSaveFile>
+#include <QProcess>
+#include <QElapsedTimer>
+#include <QAtomicInt>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QDebug>
+
+// a cache older than this is not used (30 days)
+static const qint64 MAX_CACHE_AGE = 30LL * 24 * 60 * 60 * 1000;
+// the backends need a moment before a plugged in device can be opened
+static const int HOTPLUG_RESCAN_DELAY = 1000;
+// sane_get_devices() holds the global SANE lock in this process, so the helper is used when installed
+static const int DEFAULT_HELPER_TIMEOUT = 30000;
 
 namespace KSaneIface
 {
 static FindSaneDevicesThread *s_instancesane = nullptr;
 static QMutex s_mutexsane;
+static QAtomicInt s_helperTimeout(DEFAULT_HELPER_TIMEOUT);
+
+static QString cacheFilePath()
+{
+    // the devices are the same for all applications
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) +
+           QStringLiteral("/libksane/devices.json");
+}
+
+static bool containsDevice(const QList<KSaneWidget::DeviceInfo> &list, const QString &name)
+{
+    for (int i = 0; i < list.size(); ++i) {
+        if (list.at(i).name == name) {
+            return true;
+        }
+    }
+    return false;
+}
 
 FindSaneDevicesThread *FindSaneDevicesThread::getInstance()
 {
@@ -57,18 +100,93 @@ FindSaneDevicesThread *FindSaneDevicesThread::getInstance()
     return s_instancesane;
 }
 
-FindSaneDevicesThread::FindSaneDevicesThread() : QThread(nullptr)
+FindSaneDevicesThread::FindSaneDevicesThread() : QThread(nullptr), m_cachedList(false)
 {
+    qRegisterMetaType<KSaneIface::KSaneWidget::DeviceInfo>();
+    loadCache();
+
+    m_rescanTmr.setSingleShot(true);
+    m_rescanTmr.setInterval(HOTPLUG_RESCAN_DELAY);
+    connect(&m_rescanTmr, SIGNAL(timeout()), this, SLOT(rescan()));
+
+    m_hotplugMonitor = new KSaneHotplugMonitor(this);
+    connect(m_hotplugMonitor, SIGNAL(usbDeviceAdded(int,int)), this, SLOT(scheduleRescan()));
+    connect(m_hotplugMonitor, SIGNAL(usbDeviceRemoved(int,int)), this, SLOT(removeUsbDevice(int,int)));
 }
 
 FindSaneDevicesThread::~FindSaneDevicesThread()
 {
     s_mutexsane.lock();
     wait();
+    if (s_instancesane == this) {
+        s_instancesane = nullptr;
+    }
     s_mutexsane.unlock();
 }
 
-void FindSaneDevicesThread::run()
+void FindSaneDevicesThread::loadCache()
+{
+    QFile file(cacheFilePath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    const QJsonObject cache = QJsonDocument::fromJson(file.readAll()).object();
+    const qint64 updated = cache.value(QStringLiteral("updated")).toVariant().toLongLong();
+    if ((QDateTime::currentMSecsSinceEpoch() - updated) > MAX_CACHE_AGE) {
+        return;
+    }
+
+    const QJsonArray devices = cache.value(QStringLiteral("devices")).toArray();
+    QMutexLocker locker(&m_listMutex);
+    for (int i = 0; i < devices.size(); ++i) {
+        const QJsonObject device = devices.at(i).toObject();
+        KSaneWidget::DeviceInfo deviceInfo;
+        deviceInfo.name   = device.value(QStringLiteral("name")).toString();
+        deviceInfo.vendor = device.value(QStringLiteral("vendor")).toString();
+        deviceInfo.model  = device.value(QStringLiteral("model")).toString();
+        deviceInfo.type   = device.value(QStringLiteral("type")).toString();
+        if (!deviceInfo.name.isEmpty()) {
+            m_deviceList << deviceInfo;
+        }
+    }
+    m_cachedList = !m_deviceList.isEmpty();
+}
+
+void FindSaneDevicesThread::saveCache()
+{
+    QJsonArray devices;
+    QMutexLocker locker(&m_listMutex);
+    for (int i = 0; i < m_deviceList.size(); ++i) {
+        QJsonObject device;
+        device.insert(QStringLiteral("name"), m_deviceList.at(i).name);
+        device.insert(QStringLiteral("vendor"), m_deviceList.at(i).vendor);
+        device.insert(QStringLiteral("model"), m_deviceList.at(i).model);
+        device.insert(QStringLiteral("type"), m_deviceList.at(i).type);
+        devices.append(device);
+    }
+    locker.unlock();
+
+    QJsonObject cache;
+    cache.insert(QStringLiteral("updated"), QJsonValue::fromVariant(QDateTime::currentMSecsSinceEpoch()));
+    cache.insert(QStringLiteral("devices"), devices);
+
+    const QString path = cacheFilePath();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Could not write the device cache" << path;
+        return;
+    }
+    file.write(QJsonDocument(cache).toJson(QJsonDocument::Compact));
+    file.commit();
+}
+
+void FindSaneDevicesThread::setHelperTimeout(int timeoutMsec)
+{
+    s_helperTimeout.storeRelease(qMax(0, timeoutMsec));
+}
+
+bool FindSaneDevicesThread::readDevices(QList<KSaneWidget::DeviceInfo> &deviceList)
 {
     SANE_Device const **devList;
     //SANE_Int            version;
@@ -76,9 +194,10 @@ void FindSaneDevicesThread::run()
 
     // This is unfortunately not very reliable as many back-ends do not refresh
     // the device list after the sane_init() call...
+    // the list is only valid until the next sane_get_devices() call
+    QMutexLocker locker(KSaneCore::globalMutex());
     status = sane_get_devices(&devList, SANE_FALSE);
 
-    m_deviceList.clear();
     if (status == SANE_STATUS_GOOD) {
         int i = 0;
         KSaneWidget::DeviceInfo deviceInfo;
@@ -88,15 +207,181 @@ void FindSaneDevicesThread::run()
             deviceInfo.vendor = QString::fromUtf8(devList[i]->vendor);
             deviceInfo.model = QString::fromUtf8(devList[i]->model);
             deviceInfo.type = QString::fromUtf8(devList[i]->type);
-            m_deviceList << deviceInfo;
+            deviceList << deviceInfo;
             i++;
         }
     }
+    return status == SANE_STATUS_GOOD;
+}
+
+bool FindSaneDevicesThread::readDevicesFromHelper(QList<KSaneWidget::DeviceInfo> &deviceList, int timeoutMsec)
+{
+    QProcess helper;
+    QElapsedTimer timer;
+    bool complete = false;
+
+    timer.start();
+    helper.start(QStringLiteral(KSANE_DEVICE_HELPER), QStringList(), QIODevice::ReadOnly);
+    if (!helper.waitForStarted(timeoutMsec)) {
+        qDebug() << "Could not start" << KSANE_DEVICE_HELPER << helper.errorString();
+        helper.kill();
+        helper.waitForFinished(1000);
+        return false;
+    }
+
+    // the helper writes one device per line as soon as it is known
+    while (!complete && (timer.elapsed() < timeoutMsec)) {
+        if (!helper.canReadLine() &&
+                !helper.waitForReadyRead(qMax<qint64>(0, timeoutMsec - timer.elapsed())) &&
+                (helper.state() == QProcess::NotRunning)) {
+            break;
+        }
+        while (helper.canReadLine()) {
+            QString line = QString::fromUtf8(helper.readLine());
+            line.chop(1);
+            if (line.isEmpty()) {
+                complete = true;
+                break;
+            }
+            const QStringList fields = line.split(QLatin1Char('\t'));
+            if (fields.size() != 4) {
+                continue;
+            }
+            KSaneWidget::DeviceInfo deviceInfo;
+            deviceInfo.name   = fields.at(0);
+            deviceInfo.vendor = fields.at(1);
+            deviceInfo.model  = fields.at(2);
+            deviceInfo.type   = fields.at(3);
+            deviceList << deviceInfo;
+            // the other devices can take long, so this one is usable right away
+            addFoundDevice(deviceInfo);
+        }
+    }
+
+    if (helper.state() != QProcess::NotRunning) {
+        if (!complete) {
+            qDebug() << "The device helper timed out after" << timeoutMsec << "ms";
+        }
+        // a backend can also hang in sane_exit() after the list is complete
+        helper.kill();
+        helper.waitForFinished(1000);
+    }
+    return complete;
+}
+
+void FindSaneDevicesThread::addFoundDevice(const KSaneWidget::DeviceInfo &device)
+{
+    QMutexLocker locker(&m_listMutex);
+    if (containsDevice(m_deviceList, device.name)) {
+        return;
+    }
+    m_deviceList << device;
+    locker.unlock();
+
+    emit deviceFound(device);
+}
+
+void FindSaneDevicesThread::run()
+{
+    QList<KSaneWidget::DeviceInfo> deviceList;
+    bool ok;
+
+    const int timeout = s_helperTimeout.loadAcquire();
+    if ((timeout > 0) && QFile::exists(QStringLiteral(KSANE_DEVICE_HELPER))) {
+        ok = readDevicesFromHelper(deviceList, timeout);
+    } else {
+        ok = readDevices(deviceList);
+    }
+
+    QMutexLocker listLocker(&m_listMutex);
+    m_added.clear();
+    m_removed.clear();
+    for (int i = 0; i < deviceList.size(); ++i) {
+        if (!containsDevice(m_deviceList, deviceList.at(i).name)) {
+            m_added << deviceList.at(i);
+        }
+    }
+    if (!ok) {
+        // an incomplete list does not tell which devices are gone, so the previous
+        // list stays and is still not checked
+        m_deviceList << m_added;
+        return;
+    }
+    for (int i = 0; i < m_deviceList.size(); ++i) {
+        if (!containsDevice(deviceList, m_deviceList.at(i).name)) {
+            m_removed << m_deviceList.at(i);
+        }
+    }
+    m_deviceList = deviceList;
+    m_cachedList = false;
+    listLocker.unlock();
+
+    saveCache();
+}
+
+void FindSaneDevicesThread::scheduleRescan()
+{
+    // several devices can be plugged in at once
+    m_rescanTmr.start();
+}
+
+void FindSaneDevicesThread::rescan()
+{
+    if (isRunning()) {
+        // the running thread can have missed the new device
+        m_rescanTmr.start();
+        return;
+    }
+    start();
+}
+
+void FindSaneDevicesThread::removeUsbDevice(int busNum, int devNum)
+{
+    // the libusb based backends name the devices "backend:libusb:BBB:DDD"
+    const QString usbAddress = QString::asprintf("libusb:%03d:%03d", busNum, devNum);
+    QList<KSaneWidget::DeviceInfo> removed;
+
+    // a pooled handle of the device can not be used any more
+    KSaneHandlePool::closeUsbDevice(busNum, devNum);
+
+    QMutexLocker locker(&m_listMutex);
+    for (int i = m_deviceList.size() - 1; i >= 0; --i) {
+        if (m_deviceList.at(i).name.contains(usbAddress)) {
+            removed << m_deviceList.takeAt(i);
+        }
+    }
+    if (removed.isEmpty()) {
+        locker.unlock();
+        // the device is not known by its address, so all devices must be checked
+        scheduleRescan();
+        return;
+    }
+    m_added.clear();
+    m_removed = removed;
+    locker.unlock();
+
+    qDebug() << "Removed unplugged devices without enumerating";
+    saveCache();
+    emit listChanged();
 }
 
 const QList<KSaneWidget::DeviceInfo> FindSaneDevicesThread::devicesList() const
 {
+    QMutexLocker locker(&m_listMutex);
     return m_deviceList;
 }
 
+bool FindSaneDevicesThread::isCachedList() const
+{
+    QMutexLocker locker(&m_listMutex);
+    return m_cachedList;
+}
+
+void FindSaneDevicesThread::lastChanges(QList<KSaneWidget::DeviceInfo> &added, QList<KSaneWidget::DeviceInfo> &removed) const
+{
+    QMutexLocker locker(&m_listMutex);
+    added = m_added;
+    removed = m_removed;
+}
+
 }
@@ -32,11 +32,24 @@
 #include "ksanewidget.h"
 
 #include <QThread>
+#include <QMutex>
+#include <QTimer>
 #include <QList>
 
 namespace KSaneIface
 {
 
+/**
+ * This thread reads the device list with sane_get_devices(). The last list is stored
+ * in a cache file, so that the devices are known right away when the next process
+ * starts. The cached list is replaced when the thread has read the current list.
+ *
+ * A KSaneHotplugMonitor keeps the list current. A removed USB device is taken out of the
+ * list directly when its SANE name contains the USB address; a plugged in device starts
+ * the thread again, because only the backends know if it is a scanner.
+ */
+class KSaneHotplugMonitor;
+
 class FindSaneDevicesThread : public QThread
 {
     Q_OBJECT
@@ -48,12 +61,51 @@ public:
 
     const QList<KSaneWidget::DeviceInfo> devicesList() const;
 
+    /** @return true if the list is read from the cache and is not checked yet. */
+    bool isCachedList() const;
+
+    /** Get the devices that were added and removed by the last run of the thread. */
+    void lastChanges(QList<KSaneWidget::DeviceInfo> &added, QList<KSaneWidget::DeviceInfo> &removed) const;
+
+    /** Enumerate the devices in a helper process that is killed after timeoutMsec
+     * (30 s by default). 0 enumerates the devices in this process, which blocks the
+     * opening of devices until sane_get_devices() returns. */
+    static void setHelperTimeout(int timeoutMsec);
+
+Q_SIGNALS:
+    /** This signal is emitted in the thread of this object when the list is changed
+     * without running the thread. lastChanges() returns the changes. */
+    void listChanged();
+
+    /** This signal is emitted from the running thread for every device that the device
+     * helper reports and that was not in the list. The device is added to the list right
+     * away and is not reported again by lastChanges(). */
+    void deviceFound(const KSaneIface::KSaneWidget::DeviceInfo &device);
+
+private Q_SLOTS:
+    void scheduleRescan();
+    void rescan();
+    void removeUsbDevice(int busNum, int devNum);
+
 private:
     FindSaneDevicesThread();
+    void loadCache();
+    void saveCache();
+    bool readDevices(QList<KSaneWidget::DeviceInfo> &deviceList);
+    bool readDevicesFromHelper(QList<KSaneWidget::DeviceInfo> &deviceList, int timeoutMsec);
+    void addFoundDevice(const KSaneWidget::DeviceInfo &device);
 
+    mutable QMutex                 m_listMutex;
     QList<KSaneWidget::DeviceInfo> m_deviceList;
+    QList<KSaneWidget::DeviceInfo> m_added;
+    QList<KSaneWidget::DeviceInfo> m_removed;
+    bool                           m_cachedList;
+    KSaneHotplugMonitor           *m_hotplugMonitor;
+    QTimer                         m_rescanTmr;
 };
 
 }
 
+Q_DECLARE_METATYPE(KSaneIface::KSaneWidget::DeviceInfo)
+
 #endif
@@ -0,0 +1,295 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#include "ksanegammastage.h"
+
+#include "ksanecore.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <cmath>
+#include <string.h>
+
+namespace KSaneIface
+{
+
+/** Map count values through table. The loop is unrolled, so that the independent
+ * lookups can be overlapped by the CPU. */
+template <typename T>
+static void lookup(T *data, int count, const T *table)
+{
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        T a = table[data[i]];
+        T b = table[data[i + 1]];
+        T c = table[data[i + 2]];
+        T d = table[data[i + 3]];
+        data[i]     = a;
+        data[i + 1] = b;
+        data[i + 2] = c;
+        data[i + 3] = d;
+    }
+    for (; i < count; i++) {
+        data[i] = table[data[i]];
+    }
+}
+
+/** Map interleaved RGB pixels through one table per channel. */
+template <typename T>
+static void lookupRgb(T *data, int pixels, const T *red, const T *green, const T *blue)
+{
+    for (int i = 0; i < pixels; i++) {
+        T r = red[data[0]];
+        T g = green[data[1]];
+        T b = blue[data[2]];
+        data[0] = r;
+        data[1] = g;
+        data[2] = b;
+        data += 3;
+    }
+}
+
+struct GammaCurve {
+    int brightness;
+    int contrast;
+    int gamma;
+};
+
+static bool isLinearCurve(const GammaCurve &curve)
+{
+    return (curve.brightness == 0) && (curve.contrast == 0) && (curve.gamma == 100);
+}
+
+static bool sameCurve(const GammaCurve &a, const GammaCurve &b)
+{
+    return (a.brightness == b.brightness) && (a.contrast == b.contrast) && (a.gamma == b.gamma);
+}
+
+struct KSaneGammaStage::Private {
+    void updateTables8();
+    void updateTables16();
+
+    mutable QMutex   mutex;
+    GammaCurve       curves[3];
+
+    // the tables of the page that is read, only used in the scan thread
+    GammaCurve       tableCurves[3];
+    bool             tablesValid;
+    bool             tables16Valid;
+    bool             uniform;
+    bool             active;
+    int              format;
+    int              width;
+    uchar            table8[3][256];
+    QVector<quint16> table16[3];
+};
+
+KSaneGammaStage::KSaneGammaStage()
+    : d(new Private)
+{
+    d->tablesValid   = false;
+    d->tables16Valid = false;
+    d->uniform       = true;
+    d->active        = false;
+    d->format        = KSaneCore::FormatNone;
+    d->width         = 0;
+    for (int i = 0; i < 3; i++) {
+        d->curves[i].brightness = 0;
+        d->curves[i].contrast   = 0;
+        d->curves[i].gamma      = 100;
+        d->tableCurves[i] = d->curves[i];
+    }
+}
+
+KSaneGammaStage::~KSaneGammaStage()
+{
+    delete d;
+}
+
+void KSaneGammaStage::setValues(int brightness, int contrast, int gamma)
+{
+    for (int i = 0; i < 3; i++) {
+        setChannelValues(i, brightness, contrast, gamma);
+    }
+}
+
+void KSaneGammaStage::setChannelValues(int channel, int brightness, int contrast, int gamma)
+{
+    if ((channel < 0) || (channel > 2)) {
+        return;
+    }
+    QMutexLocker locker(&d->mutex);
+    d->curves[channel].brightness = qBound(-50, brightness, 50);
+    d->curves[channel].contrast   = qBound(-50, contrast, 50);
+    d->curves[channel].gamma      = qBound(30, gamma, 300);
+}
+
+bool KSaneGammaStage::isLinear() const
+{
+    QMutexLocker locker(&d->mutex);
+    return isLinearCurve(d->curves[0]) && isLinearCurve(d->curves[1]) && isLinearCurve(d->curves[2]);
+}
+
+void KSaneGammaStage::calculateTable(QVector<int> &table, int brightness, int contrast, int gamma, double max)
+{
+    double gammaExp = 100.0 / gamma;
+    double contr    = (200.0 / (100.0 - contrast)) - 1;
+    double halfMax  = max / 2.0;
+    double bright   = (brightness / halfMax) * max;
+    double x;
+
+    for (int i = 0; i < table.size(); i++) {
+        // apply gamma
+        x = std::pow((double)i / table.size(), gammaExp) * max;
+
+        // apply contrast
+        x = (contr * (x - halfMax)) + halfMax;
+
+        // apply brightness + rounding
+        x += bright + 0.5;
+
+        // ensure correct value
+        if (x > max) {
+            x = max;
+        }
+        if (x < 0) {
+            x = 0;
+        }
+
+        table[i] = (int)x;
+    }
+}
+
+void KSaneGammaStage::Private::updateTables8()
+{
+    QVector<int> table(256);
+    for (int c = 0; c < 3; c++) {
+        if ((c > 0) && sameCurve(tableCurves[c], tableCurves[c - 1])) {
+            memcpy(table8[c], table8[c - 1], sizeof(table8[c]));
+            continue;
+        }
+        calculateTable(table, tableCurves[c].brightness, tableCurves[c].contrast,
+                       tableCurves[c].gamma, 255);
+        for (int i = 0; i < 256; i++) {
+            table8[c][i] = (uchar)table.at(i);
+        }
+    }
+}
+
+void KSaneGammaStage::Private::updateTables16()
+{
+    QVector<int> table(65536);
+    for (int c = 0; c < 3; c++) {
+        if ((c > 0) && sameCurve(tableCurves[c], tableCurves[c - 1])) {
+            table16[c] = table16[c - 1];
+            continue;
+        }
+        calculateTable(table, tableCurves[c].brightness, tableCurves[c].contrast,
+                       tableCurves[c].gamma, 65535);
+        table16[c].resize(65536);
+        quint16 *dst = table16[c].data();
+        for (int i = 0; i < 65536; i++) {
+            dst[i] = (quint16)table.at(i);
+        }
+    }
+    tables16Valid = true;
+}
+
+void KSaneGammaStage::beginPage(const KSanePage &page)
+{
+    GammaCurve curves[3];
+    d->mutex.lock();
+    for (int i = 0; i < 3; i++) {
+        curves[i] = d->curves[i];
+    }
+    d->mutex.unlock();
+
+    d->format = page.format;
+    d->width  = page.width;
+    d->active = !(isLinearCurve(curves[0]) && isLinearCurve(curves[1]) && isLinearCurve(curves[2]));
+    if (!d->active) {
+        return;
+    }
+
+    bool changed = !d->tablesValid;
+    for (int i = 0; i < 3; i++) {
+        if (!sameCurve(curves[i], d->tableCurves[i])) {
+            d->tableCurves[i] = curves[i];
+            changed = true;
+        }
+    }
+    if (changed) {
+        // the 16 bit tables are only calculated for 16 bit pages
+        d->updateTables8();
+        d->tablesValid = true;
+        d->tables16Valid = false;
+        d->uniform = sameCurve(curves[0], curves[1]) && sameCurve(curves[1], curves[2]);
+    }
+    if (!d->tables16Valid &&
+            ((d->format == KSaneCore::FormatGrayScale16) || (d->format == KSaneCore::FormatRGB_16_C))) {
+        d->updateTables16();
+    }
+}
+
+void KSaneGammaStage::processRows(char *rows, int, int rowCount, int bytesPerLine)
+{
+    if (!d->active) {
+        return;
+    }
+
+    for (int row = 0; row < rowCount; row++) {
+        char *line = rows + ((qint64)row * bytesPerLine);
+        switch (d->format) {
+        case KSaneCore::FormatGrayScale8:
+            lookup(reinterpret_cast<uchar *>(line), d->width, d->table8[0]);
+            break;
+        case KSaneCore::FormatGrayScale16:
+            lookup(reinterpret_cast<quint16 *>(line), d->width, d->table16[0].constData());
+            break;
+        case KSaneCore::FormatRGB_8_C:
+            if (d->uniform) {
+                lookup(reinterpret_cast<uchar *>(line), d->width * 3, d->table8[0]);
+            } else {
+                lookupRgb(reinterpret_cast<uchar *>(line), d->width,
+                          d->table8[0], d->table8[1], d->table8[2]);
+            }
+            break;
+        case KSaneCore::FormatRGB_16_C:
+            if (d->uniform) {
+                lookup(reinterpret_cast<quint16 *>(line), d->width * 3, d->table16[0].constData());
+            } else {
+                lookupRgb(reinterpret_cast<quint16 *>(line), d->width,
+                          d->table16[0].constData(), d->table16[1].constData(), d->table16[2].constData());
+            }
+            break;
+        default:
+            // a curve does not make sense for line-art
+            return;
+        }
+    }
+}
+
+}  // NameSpace KSaneIface
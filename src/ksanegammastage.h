@@ -0,0 +1,86 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#ifndef KSANE_GAMMA_STAGE_H
+#define KSANE_GAMMA_STAGE_H
+
+#include "ksanecore_export.h"
+#include "ksanepipeline.h"
+
+#include <QVector>
+
+namespace KSaneIface
+{
+
+/**
+ * This row stage applies a brightness, contrast and gamma curve to the rows while they are
+ * read, for backends that do not have gamma table options. The curve is the same as the one
+ * the gamma table widgets write to the backend. 8 bit data is mapped with a 256 entry table
+ * and 16 bit data with a 65536 entry table, which is only calculated when it is needed.
+ *
+ * The values can be changed at any time. They are used from the next page.
+ */
+class KSANECORE_EXPORT KSaneGammaStage : public KSaneRowStage
+{
+public:
+    KSaneGammaStage();
+    ~KSaneGammaStage();
+
+    /** Set the curve of all color channels.
+     * @param brightness is between -50 and 50 (0 is unchanged).
+     * @param contrast is between -50 and 50 (0 is unchanged).
+     * @param gamma is between 30 and 300 (100 is linear). */
+    void setValues(int brightness, int contrast, int gamma);
+
+    /** Set the curve of one color channel.
+     * @param channel is 0 for red, 1 for green and 2 for blue. Gray data uses channel 0. */
+    void setChannelValues(int channel, int brightness, int contrast, int gamma);
+
+    /** @return true if no channel is changed. */
+    bool isLinear() const;
+
+    /**
+     * Calculate a gamma table.
+     *
+     * @param table is the table to fill. The size of the table is not changed.
+     * @param brightness is the brightness
+     * @param contrast is the contrast
+     * @param gamma is the gamma value (100 is linear)
+     * @param max is the maximum table value
+     */
+    static void calculateTable(QVector<int> &table, int brightness, int contrast, int gamma, double max);
+
+    void beginPage(const KSanePage &page) override;
+    void processRows(char *rows, int firstRow, int rowCount, int bytesPerLine) override;
+
+private:
+    Q_DISABLE_COPY(KSaneGammaStage)
+    struct Private;
+    Private *const d;
+};
+
+}  // NameSpace KSaneIface
+
+#endif // KSANE_GAMMA_STAGE_H
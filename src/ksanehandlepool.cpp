@@ -0,0 +1,208 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#include "ksanehandlepool.h"
+
+#include "ksanecore.h"
+
+#include <QMutexLocker>
+#include <QAtomicInt>
+#include <QDebug>
+
+namespace KSaneIface
+{
+static KSaneHandlePool *s_instance = nullptr;
+static QMutex           s_mutex;
+static QAtomicInt       s_idleTimeout;
+
+KSaneHandlePool *KSaneHandlePool::getInstance()
+{
+    s_mutex.lock();
+
+    if (s_instance == nullptr) {
+        s_instance = new KSaneHandlePool();
+    }
+    s_mutex.unlock();
+
+    return s_instance;
+}
+
+KSaneHandlePool::KSaneHandlePool()
+{
+    m_idleTmr.setSingleShot(true);
+    connect(&m_idleTmr, SIGNAL(timeout()), this, SLOT(closeIdleHandles()));
+}
+
+KSaneHandlePool::~KSaneHandlePool()
+{
+    s_mutex.lock();
+    if (s_instance == this) {
+        s_instance = nullptr;
+    }
+    s_mutex.unlock();
+    if (!m_handles.isEmpty()) {
+        qDebug() << "The handle pool is deleted with open handles";
+    }
+}
+
+void KSaneHandlePool::setIdleTimeout(int idleMsec)
+{
+    s_idleTimeout.storeRelease(qMax(0, idleMsec));
+}
+
+SANE_Status KSaneHandlePool::open(const QString &deviceName, SANE_Handle *handle,
+                                  QVector<const SANE_Option_Descriptor *> &descriptors)
+{
+    descriptors.clear();
+
+    QMutexLocker locker(&m_mutex);
+    for (int i = 0; i < m_handles.size(); ++i) {
+        if (m_handles.at(i).deviceName == deviceName) {
+            const PooledHandle pooled = m_handles.takeAt(i);
+            *handle = pooled.handle;
+            descriptors = pooled.descriptors;
+            qDebug() << "Reusing the open handle of" << deviceName;
+            return SANE_STATUS_GOOD;
+        }
+    }
+    locker.unlock();
+
+    QMutexLocker saneLocker(KSaneCore::globalMutex());
+    return sane_open(deviceName.toLatin1().constData(), handle);
+}
+
+void KSaneHandlePool::release(const QString &deviceName, SANE_Handle handle)
+{
+    const int idleTimeout = s_idleTimeout.loadAcquire();
+    if (idleTimeout <= 0) {
+        QMutexLocker saneLocker(KSaneCore::globalMutex());
+        sane_close(handle);
+        return;
+    }
+
+    PooledHandle pooled;
+    pooled.deviceName = deviceName;
+    pooled.handle = handle;
+
+    // Option 0 is the number of options. The descriptors stay valid until sane_close().
+    const SANE_Option_Descriptor *optDesc = sane_get_option_descriptor(handle, 0);
+    SANE_Word numSaneOptions = 0;
+    if ((optDesc != nullptr) && (optDesc->size == sizeof(SANE_Word)) &&
+            (sane_control_option(handle, 0, SANE_ACTION_GET_VALUE, &numSaneOptions, nullptr) == SANE_STATUS_GOOD)) {
+        pooled.descriptors.reserve(numSaneOptions);
+        for (int i = 0; i < numSaneOptions; ++i) {
+            pooled.descriptors.append(sane_get_option_descriptor(handle, i));
+        }
+    } else {
+        // a handle without options can not be used again
+        QMutexLocker saneLocker(KSaneCore::globalMutex());
+        sane_close(handle);
+        return;
+    }
+    pooled.idle.start();
+
+    QMutexLocker locker(&m_mutex);
+    m_handles.append(pooled);
+    locker.unlock();
+
+    // the timer must be started in the thread of the pool
+    QMetaObject::invokeMethod(this, "closeIdleHandles", Qt::QueuedConnection);
+}
+
+void KSaneHandlePool::closeIdleHandles()
+{
+    const int idleTimeout = s_idleTimeout.loadAcquire();
+    QList<SANE_Handle> expired;
+    qint64 nextExpiry = -1;
+
+    QMutexLocker locker(&m_mutex);
+    for (int i = m_handles.size() - 1; i >= 0; --i) {
+        const qint64 remaining = idleTimeout - m_handles.at(i).idle.elapsed();
+        if (remaining <= 0) {
+            expired << m_handles.takeAt(i).handle;
+        } else if ((nextExpiry < 0) || (remaining < nextExpiry)) {
+            nextExpiry = remaining;
+        }
+    }
+    locker.unlock();
+
+    if (!expired.isEmpty()) {
+        QMutexLocker saneLocker(KSaneCore::globalMutex());
+        for (int i = 0; i < expired.size(); ++i) {
+            sane_close(expired.at(i));
+        }
+    }
+
+    if (nextExpiry >= 0) {
+        m_idleTmr.start(nextExpiry);
+    } else {
+        m_idleTmr.stop();
+    }
+}
+
+void KSaneHandlePool::closeAllLocked()
+{
+    QMutexLocker locker(&m_mutex);
+    for (int i = 0; i < m_handles.size(); ++i) {
+        sane_close(m_handles.at(i).handle);
+    }
+    m_handles.clear();
+}
+
+void KSaneHandlePool::deleteInstanceLocked()
+{
+    s_mutex.lock();
+    KSaneHandlePool *pool = s_instance;
+    s_mutex.unlock();
+
+    if (pool != nullptr) {
+        pool->closeAllLocked();
+        delete pool;
+    }
+}
+
+void KSaneHandlePool::closeUsbDevice(int busNum, int devNum)
+{
+    const QString usbAddress = QString::asprintf("libusb:%03d:%03d", busNum, devNum);
+
+    // the pool is only deleted with the global mutex held
+    QMutexLocker saneLocker(KSaneCore::globalMutex());
+    s_mutex.lock();
+    KSaneHandlePool *pool = s_instance;
+    s_mutex.unlock();
+    if (pool == nullptr) {
+        return;
+    }
+
+    QMutexLocker locker(&pool->m_mutex);
+    for (int i = pool->m_handles.size() - 1; i >= 0; --i) {
+        if (pool->m_handles.at(i).deviceName.contains(usbAddress)) {
+            qDebug() << "Closing the pooled handle of the unplugged" << pool->m_handles.at(i).deviceName;
+            sane_close(pool->m_handles.takeAt(i).handle);
+        }
+    }
+}
+
+}  // NameSpace KSaneIface
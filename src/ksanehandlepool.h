@@ -0,0 +1,110 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#ifndef KSANE_HANDLE_POOL_H
+#define KSANE_HANDLE_POOL_H
+
+#include "ksanecore_export.h"
+
+#include <QObject>
+#include <QMutex>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QList>
+#include <QString>
+
+// Sane includes
+extern "C"
+{
+#include <sane/saneopts.h>
+#include <sane/sane.h>
+}
+
+namespace KSaneIface
+{
+
+/**
+ * This process wide pool keeps released device handles open for an idle time, so that
+ * opening the same device again does not repeat the firmware upload and calibration
+ * that many backends do in sane_open(). A pooled handle is given out with the option
+ * descriptors that were read when it was released.
+ *
+ * The pool is disabled (idle time 0) by default, because an open handle keeps the
+ * device busy for other processes.
+ */
+class KSANECORE_EXPORT KSaneHandlePool : public QObject
+{
+    Q_OBJECT
+
+public:
+    static KSaneHandlePool *getInstance();
+    ~KSaneHandlePool();
+
+    /** Keep the released handles open for idleMsec. 0 closes them right away. */
+    static void setIdleTimeout(int idleMsec);
+
+    /** Take a pooled handle of the device or open the device with sane_open().
+     * @param descriptors is set to the option descriptors of a pooled handle.
+     * It is empty if the device was opened. */
+    SANE_Status open(const QString &deviceName, SANE_Handle *handle,
+                     QVector<const SANE_Option_Descriptor *> &descriptors);
+
+    /** Put the handle into the pool or close it if the pool is disabled.
+     * No option I/O or scan may be running on the handle. */
+    void release(const QString &deviceName, SANE_Handle handle);
+
+    /** Close all pooled handles. The caller must hold KSaneCore::globalMutex(). */
+    void closeAllLocked();
+
+    /** Close the pooled handles and delete the pool if it was created.
+     * The caller must hold KSaneCore::globalMutex(). */
+    static void deleteInstanceLocked();
+
+    /** Close the pooled handles of an unplugged USB device. The libusb based backends
+     * name the devices "backend:libusb:BBB:DDD". */
+    static void closeUsbDevice(int busNum, int devNum);
+
+private Q_SLOTS:
+    void closeIdleHandles();
+
+private:
+    KSaneHandlePool();
+
+    struct PooledHandle {
+        QString                                 deviceName;
+        SANE_Handle                             handle;
+        QVector<const SANE_Option_Descriptor *> descriptors;
+        QElapsedTimer                           idle;
+    };
+
+    QMutex              m_mutex;
+    QList<PooledHandle> m_handles;
+    QTimer              m_idleTmr;
+};
+
+}  // NameSpace KSaneIface
+
+#endif
@@ -0,0 +1,251 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#include "ksanehotplugmonitor.h"
+
+#ifdef HAVE_UDEV
+extern "C"
+{
+#include <libudev.h>
+}
+#endif
+
+#include <QSocketNotifier>
+#include <QDir>
+#include <QFile>
+#include <QList>
+#include <QDebug>
+
+#include <stdlib.h>
+
+static const int USB_POLL_INTERVAL = 2000;
+static const char USB_SYSFS_PATH[] = "/sys/bus/usb/devices";
+// hubs are never scanners
+static const int USB_CLASS_HUB = 9;
+// the interface classes of devices that are never scanners: audio, communication, HID,
+// mass storage, hub, CDC data, smart card, video and wireless controllers
+static const int NON_SCANNER_CLASSES[] = { 0x01, 0x02, 0x03, 0x08, 0x09, 0x0a, 0x0b, 0x0e, 0xe0 };
+
+namespace KSaneIface
+{
+
+static int readSysfsNumber(const QString &path, int base)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+    bool ok;
+    int value = file.readAll().trimmed().toInt(&ok, base);
+    return ok ? value : -1;
+}
+
+/**
+ * A multi-function device can have a mass storage interface next to the scanner, so a
+ * device is only ignored if none of its interfaces can belong to a scanner.
+ * @return true if all interface classes are known to never be used by scanners.
+ */
+static bool isNeverScanner(const QList<int> &interfaceClasses)
+{
+    if (interfaceClasses.isEmpty()) {
+        return false;
+    }
+    const int count = sizeof(NON_SCANNER_CLASSES) / sizeof(NON_SCANNER_CLASSES[0]);
+    for (int i = 0; i < interfaceClasses.size(); ++i) {
+        int j = 0;
+        while ((j < count) && (NON_SCANNER_CLASSES[j] != interfaceClasses.at(i))) {
+            j++;
+        }
+        if (j == count) {
+            return false;
+        }
+    }
+    return true;
+}
+
+KSaneHotplugMonitor::KSaneHotplugMonitor(QObject *parent)
+    : QObject(parent),
+      m_udev(nullptr),
+      m_monitor(nullptr),
+      m_notifier(nullptr)
+{
+    if (!startUdev()) {
+        startPolling();
+    }
+}
+
+KSaneHotplugMonitor::~KSaneHotplugMonitor()
+{
+    delete m_notifier;
+#ifdef HAVE_UDEV
+    if (m_monitor) {
+        udev_monitor_unref(m_monitor);
+    }
+    if (m_udev) {
+        udev_unref(m_udev);
+    }
+#endif
+}
+
+bool KSaneHotplugMonitor::usesUdev() const
+{
+    return m_notifier != nullptr;
+}
+
+bool KSaneHotplugMonitor::startUdev()
+{
+#ifdef HAVE_UDEV
+    m_udev = udev_new();
+    if (m_udev == nullptr) {
+        return false;
+    }
+    m_monitor = udev_monitor_new_from_netlink(m_udev, "udev");
+    if ((m_monitor == nullptr) ||
+            (udev_monitor_filter_add_match_subsystem_devtype(m_monitor, "usb", "usb_device") < 0) ||
+            (udev_monitor_enable_receiving(m_monitor) < 0)) {
+        qDebug() << "Could not monitor the udev events, polling the USB devices";
+        if (m_monitor) {
+            udev_monitor_unref(m_monitor);
+            m_monitor = nullptr;
+        }
+        udev_unref(m_udev);
+        m_udev = nullptr;
+        return false;
+    }
+
+    m_notifier = new QSocketNotifier(udev_monitor_get_fd(m_monitor), QSocketNotifier::Read, this);
+    connect(m_notifier, SIGNAL(activated(int)), this, SLOT(udevEvent()));
+    return true;
+#else
+    return false;
+#endif
+}
+
+void KSaneHotplugMonitor::udevEvent()
+{
+#ifdef HAVE_UDEV
+    struct udev_device *device = udev_monitor_receive_device(m_monitor);
+    if (device == nullptr) {
+        return;
+    }
+
+    const QByteArray action = udev_device_get_action(device);
+    // the properties are also available in the remove event
+    const char *busNum = udev_device_get_property_value(device, "BUSNUM");
+    const char *devNum = udev_device_get_property_value(device, "DEVNUM");
+    const char *devClass = udev_device_get_sysattr_value(device, "bDeviceClass");
+    // ":ff0000:070102:" lists the class, subclass and protocol of each interface
+    const QList<QByteArray> interfaces = QByteArray(udev_device_get_property_value(device, "ID_USB_INTERFACES"))
+                                         .split(':');
+    QList<int> interfaceClasses;
+    for (int i = 0; i < interfaces.size(); ++i) {
+        if (interfaces.at(i).size() >= 2) {
+            interfaceClasses << interfaces.at(i).left(2).toInt(nullptr, 16);
+        }
+    }
+
+    if ((busNum != nullptr) && (devNum != nullptr) && !isNeverScanner(interfaceClasses)) {
+        if (action == "add") {
+            if ((devClass == nullptr) || (QByteArray(devClass).toInt(nullptr, 16) != USB_CLASS_HUB)) {
+                emit usbDeviceAdded(atoi(busNum), atoi(devNum));
+            }
+        } else if (action == "remove") {
+            emit usbDeviceRemoved(atoi(busNum), atoi(devNum));
+        }
+    }
+    udev_device_unref(device);
+#endif
+}
+
+void KSaneHotplugMonitor::startPolling()
+{
+    if (!QDir(QString::fromLatin1(USB_SYSFS_PATH)).exists()) {
+        qDebug() << "No USB devices to monitor";
+        return;
+    }
+    m_usbDevices = readUsbDevices();
+    m_pollTmr.setSingleShot(false);
+    m_pollTmr.setInterval(USB_POLL_INTERVAL);
+    connect(&m_pollTmr, SIGNAL(timeout()), this, SLOT(pollUsbDevices()));
+    m_pollTmr.start();
+}
+
+QMap<QString, KSaneHotplugMonitor::UsbAddress> KSaneHotplugMonitor::readUsbDevices() const
+{
+    QMap<QString, UsbAddress> devices;
+    const QString sysfsPath = QString::fromLatin1(USB_SYSFS_PATH);
+    const QStringList entries = QDir(sysfsPath).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+
+    // the interfaces ("1-1:1.0") are not devices, but tell what the device is
+    QMap<QString, QList<int> > interfaceClasses;
+    for (int i = 0; i < entries.size(); ++i) {
+        const int colon = entries.at(i).indexOf(QLatin1Char(':'));
+        if (colon > 0) {
+            const int interfaceClass = readSysfsNumber(sysfsPath + QLatin1Char('/') + entries.at(i) +
+                                                       QStringLiteral("/bInterfaceClass"), 16);
+            if (interfaceClass >= 0) {
+                interfaceClasses[entries.at(i).left(colon)] << interfaceClass;
+            }
+        }
+    }
+
+    for (int i = 0; i < entries.size(); ++i) {
+        if (entries.at(i).contains(QLatin1Char(':'))) {
+            continue;
+        }
+        const QString path = sysfsPath + QLatin1Char('/') + entries.at(i);
+        if ((readSysfsNumber(path + QStringLiteral("/bDeviceClass"), 16) == USB_CLASS_HUB) ||
+                isNeverScanner(interfaceClasses.value(entries.at(i)))) {
+            continue;
+        }
+        const int busNum = readSysfsNumber(path + QStringLiteral("/busnum"), 10);
+        const int devNum = readSysfsNumber(path + QStringLiteral("/devnum"), 10);
+        if ((busNum >= 0) && (devNum >= 0)) {
+            devices.insert(entries.at(i), UsbAddress(busNum, devNum));
+        }
+    }
+    return devices;
+}
+
+void KSaneHotplugMonitor::pollUsbDevices()
+{
+    const QMap<QString, UsbAddress> devices = readUsbDevices();
+
+    // a device that is plugged into the same port again gets a new device number
+    QMap<QString, UsbAddress>::const_iterator it;
+    for (it = m_usbDevices.constBegin(); it != m_usbDevices.constEnd(); ++it) {
+        if (devices.value(it.key(), UsbAddress(-1, -1)) != it.value()) {
+            emit usbDeviceRemoved(it.value().first, it.value().second);
+        }
+    }
+    for (it = devices.constBegin(); it != devices.constEnd(); ++it) {
+        if (m_usbDevices.value(it.key(), UsbAddress(-1, -1)) != it.value()) {
+            emit usbDeviceAdded(it.value().first, it.value().second);
+        }
+    }
+    m_usbDevices = devices;
+}
+
+}  // NameSpace KSaneIface
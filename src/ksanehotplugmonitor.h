@@ -0,0 +1,83 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#ifndef KSANE_HOTPLUG_MONITOR_H
+#define KSANE_HOTPLUG_MONITOR_H
+
+#include <QObject>
+#include <QTimer>
+#include <QMap>
+#include <QPair>
+#include <QString>
+
+class QSocketNotifier;
+struct udev;
+struct udev_monitor;
+
+namespace KSaneIface
+{
+
+/**
+ * This class notices when USB devices are plugged in or removed. The udev netlink
+ * socket is used when libksane is built with libudev. Otherwise, or if udev is not
+ * available, /sys/bus/usb/devices is polled. Hubs and devices whose interfaces are
+ * never used by scanners, like keyboards or USB sticks, are not reported.
+ */
+class KSaneHotplugMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit KSaneHotplugMonitor(QObject *parent = nullptr);
+    ~KSaneHotplugMonitor();
+
+    /** @return true if the udev events are used and false if the devices are polled. */
+    bool usesUdev() const;
+
+Q_SIGNALS:
+    void usbDeviceAdded(int busNum, int devNum);
+    void usbDeviceRemoved(int busNum, int devNum);
+
+private Q_SLOTS:
+    void udevEvent();
+    void pollUsbDevices();
+
+private:
+    typedef QPair<int, int> UsbAddress;
+
+    bool startUdev();
+    void startPolling();
+    QMap<QString, UsbAddress> readUsbDevices() const;
+
+    struct udev              *m_udev;
+    struct udev_monitor      *m_monitor;
+    QSocketNotifier          *m_notifier;
+    QTimer                    m_pollTmr;
+    QMap<QString, UsbAddress> m_usbDevices;
+};
+
+}  // NameSpace KSaneIface
+
+#endif // KSANE_HOTPLUG_MONITOR_H
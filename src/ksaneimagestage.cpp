@@ -0,0 +1,59 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#include "ksaneimagestage.h"
+
+#include "ksanewidget.h"
+
+#include <QImage>
+#include <QVariant>
+
+namespace KSaneIface
+{
+
+KSaneImageStage::KSaneImageStage(bool keepData)
+    : m_keepData(keepData)
+{
+}
+
+void KSaneImageStage::processPage(KSanePage &page)
+{
+    QImage image = KSaneWidget::toQImageSilent(page.data,
+                                               page.width,
+                                               page.height,
+                                               page.bytesPerLine,
+                                               page.dpi,
+                                               (KSaneWidget::ImageFormat)page.format);
+    if (page.format == KSaneWidget::FormatBlackWhite) {
+        // the line-art image uses the buffer of the data
+        image = image.copy();
+    }
+    page.properties.insert(QStringLiteral("image"), image);
+    if (!m_keepData) {
+        page.data.clear();
+    }
+}
+
+}  // NameSpace KSaneIface
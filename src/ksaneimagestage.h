@@ -0,0 +1,54 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#ifndef KSANE_IMAGE_STAGE_H
+#define KSANE_IMAGE_STAGE_H
+
+#include "ksane_export.h"
+#include "ksanepipeline.h"
+
+namespace KSaneIface
+{
+
+/**
+ * This page stage converts the scanned data to a QImage with KSaneWidget::toQImageSilent().
+ * The image is stored in the "image" property of the page, so the conversion is done in
+ * a worker thread of the pipeline instead of the GUI thread.
+ */
+class KSANE_EXPORT KSaneImageStage : public KSanePageStage
+{
+public:
+    /** @param keepData is false to free the scanned data when the image is created. */
+    explicit KSaneImageStage(bool keepData = true);
+
+    void processPage(KSanePage &page) override;
+
+private:
+    bool m_keepData;
+};
+
+}  // NameSpace KSaneIface
+
+#endif // KSANE_IMAGE_STAGE_H
@@ -0,0 +1,242 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#include "ksaneoptionpoller.h"
+
+#include "ksaneoption.h"
+
+#include <QMutexLocker>
+#include <QDebug>
+
+static const int DEFAULT_MIN_POLL_INTERVAL = 100;
+static const int DEFAULT_MAX_POLL_INTERVAL = 1000;
+
+namespace KSaneIface
+{
+static bool isPressed(const QByteArray &value)
+{
+    for (int i = 0; i < value.size(); i++) {
+        if (value.at(i) != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+KSaneOptionPoller::KSaneOptionPoller(SANE_Handle handle, QMutex *deviceMutex, QObject *parent)
+    : QThread(parent),
+      m_handle(handle),
+      m_deviceMutex(deviceMutex),
+      m_minInterval(DEFAULT_MIN_POLL_INTERVAL),
+      m_maxInterval(DEFAULT_MAX_POLL_INTERVAL),
+      m_interval(DEFAULT_MIN_POLL_INTERVAL),
+      m_scanButton(nullptr),
+      m_paused(false),
+      m_polling(false),
+      m_stop(false)
+{
+    connect(this, SIGNAL(resultsReady()), this, SLOT(deliverResults()), Qt::QueuedConnection);
+}
+
+KSaneOptionPoller::~KSaneOptionPoller()
+{
+    stop();
+}
+
+void KSaneOptionPoller::stop()
+{
+    QMutexLocker locker(&m_mutex);
+    m_stop = true;
+    m_options.clear();
+    m_results.clear();
+    m_wake.wakeAll();
+    locker.unlock();
+    wait();
+}
+
+void KSaneOptionPoller::setOptions(const QList<KSaneOption *> &options)
+{
+    QMutexLocker locker(&m_mutex);
+    QList<PollOption> polls;
+    for (int i = 0; i < options.size(); i++) {
+        PollOption poll;
+        poll.option = options.at(i);
+        poll.index  = options.at(i)->index();
+        poll.size   = options.at(i)->valueSize();
+        // keep the last value so that an unchanged option is not delivered again
+        for (int j = 0; j < m_options.size(); j++) {
+            if (m_options.at(j).option == poll.option) {
+                poll.lastValue = m_options.at(j).lastValue;
+                break;
+            }
+        }
+        polls.append(poll);
+    }
+    m_options = polls;
+
+    // drop the results of the options that are not polled any more
+    for (int i = m_results.size() - 1; i >= 0; i--) {
+        if (!options.contains(m_results.at(i).option)) {
+            m_results.removeAt(i);
+        }
+    }
+
+    m_interval = m_minInterval;
+    m_wake.wakeAll();
+}
+
+void KSaneOptionPoller::setInterval(int minMsec, int maxMsec)
+{
+    QMutexLocker locker(&m_mutex);
+    m_minInterval = qMax(1, minMsec);
+    m_maxInterval = qMax(m_minInterval, maxMsec);
+    m_interval = m_minInterval;
+    m_wake.wakeAll();
+}
+
+void KSaneOptionPoller::pause()
+{
+    QMutexLocker locker(&m_mutex);
+    m_paused = true;
+    if (QThread::currentThread() == this) {
+        return;
+    }
+    while (m_polling) {
+        m_roundDone.wait(&m_mutex);
+    }
+}
+
+void KSaneOptionPoller::resume()
+{
+    QMutexLocker locker(&m_mutex);
+    m_paused = false;
+    m_interval = m_minInterval;
+    m_wake.wakeAll();
+}
+
+int KSaneOptionPoller::currentInterval()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_interval;
+}
+
+void KSaneOptionPoller::setScanButton(KSaneOption *option)
+{
+    QMutexLocker locker(&m_mutex);
+    m_scanButton = option;
+}
+
+void KSaneOptionPoller::deliverResults()
+{
+    QMutexLocker locker(&m_mutex);
+    QList<PollResult> results = m_results;
+    m_results.clear();
+    locker.unlock();
+
+    for (int i = 0; i < results.size(); i++) {
+        results.at(i).option->readFinished(results.at(i).value, SANE_STATUS_GOOD);
+    }
+}
+
+void KSaneOptionPoller::run()
+{
+    SANE_Status status;
+    SANE_Int info;
+
+    QMutexLocker locker(&m_mutex);
+    while (!m_stop) {
+        if (m_paused || m_options.isEmpty()) {
+            m_wake.wait(&m_mutex);
+            continue;
+        }
+
+        QList<PollOption> polls = m_options;
+        m_polling = true;
+        locker.unlock();
+
+        QList<PollResult> changed;
+        for (int i = 0; i < polls.size(); i++) {
+            QByteArray value(polls.at(i).size, '\0');
+            m_deviceMutex->lock();
+            status = sane_control_option(m_handle, polls.at(i).index, SANE_ACTION_GET_VALUE, value.data(), &info);
+            m_deviceMutex->unlock();
+            if (status != SANE_STATUS_GOOD) {
+                continue;
+            }
+            if (value != polls.at(i).lastValue) {
+                PollResult result;
+                result.option = polls.at(i).option;
+                result.value  = value;
+                changed.append(result);
+            }
+        }
+
+        locker.relock();
+        m_polling = false;
+        m_roundDone.wakeAll();
+        if (m_stop) {
+            break;
+        }
+
+        // the option list can have been changed while the lock was released
+        bool pressed = false;
+        for (int i = 0; i < changed.size(); i++) {
+            for (int j = 0; j < m_options.size(); j++) {
+                if (m_options.at(j).option == changed.at(i).option) {
+                    // the first read of an option is not a press
+                    if ((m_options.at(j).option == m_scanButton) &&
+                            !m_options.at(j).lastValue.isEmpty() &&
+                            !isPressed(m_options.at(j).lastValue) &&
+                            isPressed(changed.at(i).value)) {
+                        pressed = true;
+                    }
+                    m_options[j].lastValue = changed.at(i).value;
+                    m_results.append(changed.at(i));
+                    break;
+                }
+            }
+        }
+
+        if (pressed) {
+            // the receiver starts the scan directly from this thread
+            locker.unlock();
+            emit scanButtonPressed();
+            locker.relock();
+            if (m_stop) {
+                break;
+            }
+        }
+
+        if (!changed.isEmpty()) {
+            m_interval = m_minInterval;
+            emit resultsReady();
+        } else {
+            m_interval = qMin(m_interval * 2, m_maxInterval);
+        }
+        m_wake.wait(&m_mutex, m_interval);
+    }
+}
+
+}  // NameSpace KSaneIface
@@ -0,0 +1,130 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#ifndef KSANE_OPTION_POLLER_H
+#define KSANE_OPTION_POLLER_H
+
+// Sane includes
+extern "C"
+{
+#include <sane/saneopts.h>
+#include <sane/sane.h>
+}
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QByteArray>
+#include <QList>
+
+namespace KSaneIface
+{
+
+class KSaneOption;
+
+/**
+ * This thread polls the read-only options (hardware buttons, sensors) of a device.
+ *
+ * The poll interval starts at the minimum interval and is doubled after every poll
+ * round without a changed value, up to the maximum interval. A changed value resets
+ * the interval to the minimum. Only the changed values are delivered to the options
+ * in the thread of this object by calling KSaneOption::readFinished().
+ */
+class KSaneOptionPoller : public QThread
+{
+    Q_OBJECT
+
+public:
+    KSaneOptionPoller(SANE_Handle handle, QMutex *deviceMutex, QObject *parent = nullptr);
+    ~KSaneOptionPoller();
+
+    /** Set the options to poll. An empty list makes the thread sleep until options are set.
+     * Setting the options restarts at the minimum interval. */
+    void setOptions(const QList<KSaneOption *> &options);
+
+    /** Set the limits of the adaptive poll interval. */
+    void setInterval(int minMsec, int maxMsec);
+
+    /** @return the interval that is used for the next poll round. */
+    int currentInterval();
+
+    /** Stop polling. This returns only after a poll round that is in progress has
+     * finished, so the handle can be used by a scan or preview thread afterwards.
+     * Calling this from the poller thread does not wait. */
+    void pause();
+
+    /** Continue polling after pause() at the minimum interval. */
+    void resume();
+
+    /** Emit scanButtonPressed() when the value of option changes from zero to non-zero.
+     * The option must be in the polled options. nullptr disables the detection. */
+    void setScanButton(KSaneOption *option);
+
+    void stop();
+
+Q_SIGNALS:
+    void resultsReady();
+
+    /** This signal is emitted in the poller thread as soon as the press is detected. */
+    void scanButtonPressed();
+
+private Q_SLOTS:
+    void deliverResults();
+
+protected:
+    void run() override;
+
+private:
+    struct PollOption {
+        KSaneOption *option;
+        int          index;
+        int          size;
+        QByteArray   lastValue;
+    };
+
+    struct PollResult {
+        KSaneOption *option;
+        QByteArray   value;
+    };
+
+    SANE_Handle        m_handle;
+    QMutex            *m_deviceMutex;
+    QMutex             m_mutex;
+    QWaitCondition     m_wake;
+    QWaitCondition     m_roundDone;
+    QList<PollOption>  m_options;
+    QList<PollResult>  m_results;
+    int                m_minInterval;
+    int                m_maxInterval;
+    int                m_interval;
+    KSaneOption       *m_scanButton;
+    bool               m_paused;
+    bool               m_polling;
+    bool               m_stop;
+};
+
+}  // NameSpace KSaneIface
+
+#endif
@@ -0,0 +1,183 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#include "ksaneoptionvalue.h"
+
+#include <string.h>
+
+#include <QVarLengthArray>
+#include <QDebug>
+
+namespace KSaneIface
+{
+
+int KSaneOptionValue::optionCount(SANE_Handle handle)
+{
+    // option 0 is the number of options
+    SANE_Word count = 0;
+    SANE_Int  info;
+    if (handle == nullptr) {
+        return 0;
+    }
+    if (sane_control_option(handle, 0, SANE_ACTION_GET_VALUE, &count, &info) != SANE_STATUS_GOOD) {
+        return 0;
+    }
+    return count;
+}
+
+int KSaneOptionValue::findOption(SANE_Handle handle, const QString &name)
+{
+    const QByteArray optName = name.toLatin1();
+    const int count = optionCount(handle);
+    for (int i = 1; i < count; ++i) {
+        const SANE_Option_Descriptor *optDesc = sane_get_option_descriptor(handle, i);
+        if ((optDesc != nullptr) && (optDesc->name != nullptr) && (optName == optDesc->name)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+QStringList KSaneOptionValue::optionNames(SANE_Handle handle)
+{
+    QStringList names;
+    const int count = optionCount(handle);
+    for (int i = 1; i < count; ++i) {
+        const SANE_Option_Descriptor *optDesc = sane_get_option_descriptor(handle, i);
+        if ((optDesc == nullptr) || (optDesc->name == nullptr) ||
+                (optDesc->type == SANE_TYPE_GROUP) || (optDesc->type == SANE_TYPE_BUTTON)) {
+            continue;
+        }
+        names.append(QString::fromLatin1(optDesc->name));
+    }
+    return names;
+}
+
+bool KSaneOptionValue::getValue(SANE_Handle handle, const QString &name, QString &value)
+{
+    SANE_Status status;
+    SANE_Int    info;
+    SANE_Word   word;
+
+    const int index = findOption(handle, name);
+    if (index < 0) {
+        return false;
+    }
+    const SANE_Option_Descriptor *optDesc = sane_get_option_descriptor(handle, index);
+    if ((optDesc == nullptr) || !SANE_OPTION_IS_ACTIVE(optDesc->cap)) {
+        return false;
+    }
+    if ((optDesc->type != SANE_TYPE_STRING) && (optDesc->size != sizeof(SANE_Word))) {
+        // arrays (gamma tables) are not supported
+        return false;
+    }
+
+    QVarLengthArray<char> data(optDesc->size + 1);
+    status = sane_control_option(handle, index, SANE_ACTION_GET_VALUE, data.data(), &info);
+    if (status != SANE_STATUS_GOOD) {
+        return false;
+    }
+
+    switch (optDesc->type) {
+    case SANE_TYPE_BOOL:
+        memcpy(&word, data.data(), sizeof(SANE_Word));
+        value = (word != SANE_FALSE) ? QStringLiteral("true") : QStringLiteral("false");
+        return true;
+    case SANE_TYPE_INT:
+        memcpy(&word, data.data(), sizeof(SANE_Word));
+        value = QString::number(word);
+        return true;
+    case SANE_TYPE_FIXED:
+        memcpy(&word, data.data(), sizeof(SANE_Word));
+        value = QString::number(SANE_UNFIX(word));
+        return true;
+    case SANE_TYPE_STRING:
+        data[optDesc->size] = 0;
+        value = QString::fromUtf8(data.data());
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool KSaneOptionValue::setValue(SANE_Handle handle, const QString &name, const QString &value)
+{
+    SANE_Status status;
+    SANE_Int    info;
+    SANE_Word   word;
+    QByteArray  data;
+    bool        ok = true;
+
+    const int index = findOption(handle, name);
+    if (index < 0) {
+        return false;
+    }
+    const SANE_Option_Descriptor *optDesc = sane_get_option_descriptor(handle, index);
+    if ((optDesc == nullptr) || !SANE_OPTION_IS_SETTABLE(optDesc->cap) || !SANE_OPTION_IS_ACTIVE(optDesc->cap)) {
+        return false;
+    }
+    if ((optDesc->type != SANE_TYPE_STRING) && (optDesc->size != sizeof(SANE_Word))) {
+        return false;
+    }
+
+    // strip the unit
+    const QString number = value.section(QLatin1Char(' '), 0, 0);
+
+    switch (optDesc->type) {
+    case SANE_TYPE_BOOL:
+        word = ((value.compare(QStringLiteral("true"), Qt::CaseInsensitive) == 0) ||
+                (value.compare(QStringLiteral("1")) == 0)) ? SANE_TRUE : SANE_FALSE;
+        break;
+    case SANE_TYPE_INT:
+        // accept float formatting of the string
+        word = (SANE_Word)number.toFloat(&ok);
+        break;
+    case SANE_TYPE_FIXED:
+        word = SANE_FIX(number.toFloat(&ok));
+        break;
+    case SANE_TYPE_STRING:
+        data = value.toUtf8().left(optDesc->size - 1);
+        // pad with zeros up to the size of the option
+        data.append(QByteArray(optDesc->size - data.size(), '\0'));
+        break;
+    default:
+        return false;
+    }
+    if (!ok) {
+        return false;
+    }
+    if (optDesc->type != SANE_TYPE_STRING) {
+        data = QByteArray((const char *)&word, sizeof(SANE_Word));
+    }
+
+    status = sane_control_option(handle, index, SANE_ACTION_SET_VALUE, data.data(), &info);
+    if (status != SANE_STATUS_GOOD) {
+        qDebug() << name << "sane_control_option returned:" << sane_strstatus(status);
+        return false;
+    }
+    return true;
+}
+
+}  // NameSpace KSaneIface
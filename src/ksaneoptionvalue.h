@@ -0,0 +1,67 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#ifndef KSANE_OPTION_VALUE_H
+#define KSANE_OPTION_VALUE_H
+
+#include "ksanecore_export.h"
+
+#include <QString>
+#include <QStringList>
+
+// Sane includes
+extern "C"
+{
+#include <sane/saneopts.h>
+#include <sane/sane.h>
+}
+
+namespace KSaneIface
+{
+
+/**
+ * The option values of KSaneCore as strings. Boolean, integer, fixed point and string
+ * options with a single value are supported. This is shared by KSaneCore and the scan
+ * host process.
+ */
+class KSANECORE_EXPORT KSaneOptionValue
+{
+public:
+    /** @return the number of options including option 0. */
+    static int optionCount(SANE_Handle handle);
+
+    /** @return the index of the option or -1 if the device has no such option. */
+    static int findOption(SANE_Handle handle, const QString &name);
+
+    /** @return the names of the options that have a value. */
+    static QStringList optionNames(SANE_Handle handle);
+
+    static bool getValue(SANE_Handle handle, const QString &name, QString &value);
+    static bool setValue(SANE_Handle handle, const QString &name, const QString &value);
+};
+
+}  // NameSpace KSaneIface
+
+#endif
@@ -0,0 +1,181 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#include "ksaneoptionworker.h"
+
+#include "ksaneoption.h"
+
+#include <QMutexLocker>
+#include <QDebug>
+
+namespace KSaneIface
+{
+KSaneOptionWorker::KSaneOptionWorker(SANE_Handle handle, QObject *parent)
+    : QThread(parent),
+      m_handle(handle),
+      m_busy(false),
+      m_stop(false),
+      m_resultsSignaled(false)
+{
+    // the results are delivered in the thread of this object
+    connect(this, SIGNAL(resultsReady()), this, SLOT(deliverResults()), Qt::QueuedConnection);
+}
+
+KSaneOptionWorker::~KSaneOptionWorker()
+{
+    stop();
+}
+
+QMutex *KSaneOptionWorker::deviceMutex()
+{
+    return &m_deviceMutex;
+}
+
+void KSaneOptionWorker::stop()
+{
+    QMutexLocker locker(&m_jobMutex);
+    m_stop = true;
+    m_jobs.clear();
+    m_results.clear();
+    m_jobAdded.wakeAll();
+    m_idle.wakeAll();
+    locker.unlock();
+    wait();
+}
+
+bool KSaneOptionWorker::write(KSaneOption *option, int index, const QByteArray &data)
+{
+    QMutexLocker locker(&m_jobMutex);
+    for (int i = 0; i < m_jobs.size(); i++) {
+        if (m_jobs.at(i).write && (m_jobs.at(i).option == option)) {
+            m_jobs[i].data = data;
+            return false;
+        }
+    }
+
+    Job job;
+    job.option = option;
+    job.index  = index;
+    job.write  = true;
+    job.data   = data;
+    job.status = SANE_STATUS_GOOD;
+    job.info   = 0;
+    m_jobs.append(job);
+    m_jobAdded.wakeOne();
+    return true;
+}
+
+void KSaneOptionWorker::read(KSaneOption *option, int index, int size)
+{
+    QMutexLocker locker(&m_jobMutex);
+    for (int i = 0; i < m_jobs.size(); i++) {
+        if (!m_jobs.at(i).write && (m_jobs.at(i).option == option)) {
+            return;
+        }
+    }
+
+    Job job;
+    job.option = option;
+    job.index  = index;
+    job.write  = false;
+    job.data   = QByteArray(size, '\0');
+    job.status = SANE_STATUS_GOOD;
+    job.info   = 0;
+    m_jobs.append(job);
+    m_jobAdded.wakeOne();
+}
+
+void KSaneOptionWorker::waitForIdle()
+{
+    QMutexLocker locker(&m_jobMutex);
+    // the jobs queued before start() are waited for too, a stopped worker drops them
+    while (!m_stop && (m_busy || !m_jobs.isEmpty())) {
+        m_idle.wait(&m_jobMutex);
+    }
+}
+
+void KSaneOptionWorker::flush()
+{
+    do {
+        waitForIdle();
+    } while (deliverResults());
+}
+
+bool KSaneOptionWorker::deliverResults()
+{
+    QMutexLocker locker(&m_jobMutex);
+    QList<Job> results = m_results;
+    m_results.clear();
+    m_resultsSignaled = false;
+    locker.unlock();
+
+    // the callbacks can queue new jobs
+    for (int i = 0; i < results.size(); i++) {
+        const Job &job = results.at(i);
+        if (job.write) {
+            job.option->writeFinished(job.data, job.status, job.info);
+        } else {
+            job.option->readFinished(job.data, job.status);
+        }
+    }
+    return !results.isEmpty();
+}
+
+void KSaneOptionWorker::run()
+{
+    QMutexLocker jobLocker(&m_jobMutex);
+    while (!m_stop) {
+        if (m_jobs.isEmpty()) {
+            m_busy = false;
+            m_idle.wakeAll();
+            m_jobAdded.wait(&m_jobMutex);
+            continue;
+        }
+
+        Job job = m_jobs.takeFirst();
+        m_busy = true;
+        jobLocker.unlock();
+
+        m_deviceMutex.lock();
+        job.status = sane_control_option(m_handle, job.index,
+                                         job.write ? SANE_ACTION_SET_VALUE : SANE_ACTION_GET_VALUE,
+                                         job.data.data(), &job.info);
+        m_deviceMutex.unlock();
+
+        jobLocker.relock();
+        if (m_stop) {
+            break;
+        }
+        m_results.append(job);
+        if (!m_resultsSignaled) {
+            m_resultsSignaled = true;
+            emit resultsReady();
+        }
+    }
+    m_busy = false;
+    m_idle.wakeAll();
+}
+
+}  // NameSpace KSaneIface
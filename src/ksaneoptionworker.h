@@ -0,0 +1,117 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#ifndef KSANE_OPTION_WORKER_H
+#define KSANE_OPTION_WORKER_H
+
+// Sane includes
+extern "C"
+{
+#include <sane/saneopts.h>
+#include <sane/sane.h>
+}
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QByteArray>
+#include <QList>
+
+namespace KSaneIface
+{
+
+class KSaneOption;
+
+/**
+ * This thread executes the option reads and writes of the widgets so that a slow
+ * device does not block the GUI. All device access is serialised with deviceMutex().
+ *
+ * The results are delivered in the thread of this object (the GUI thread) by calling
+ * KSaneOption::writeFinished() and KSaneOption::readFinished().
+ */
+class KSaneOptionWorker : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit KSaneOptionWorker(SANE_Handle handle, QObject *parent = nullptr);
+    ~KSaneOptionWorker();
+
+    /** The mutex that must be held by everybody calling sane_control_option()
+     * or sane_get_option_descriptor() for this handle. */
+    QMutex *deviceMutex();
+
+    /** Queue a write. A queued write of the same option that has not started yet is
+     * replaced, so that only the last value of a slider drag is written.
+     * @return true if a new write was queued and false if a queued one was replaced. */
+    bool write(KSaneOption *option, int index, const QByteArray &data);
+
+    /** Queue a read. Nothing is queued if a read of the option is already waiting. */
+    void read(KSaneOption *option, int index, int size);
+
+    /** Block until all queued jobs are executed. The results are not delivered. */
+    void waitForIdle();
+
+    /** Block until all queued jobs are executed and deliver the results.
+     * Jobs queued by the delivered results are also executed. */
+    void flush();
+
+    void stop();
+
+Q_SIGNALS:
+    void resultsReady();
+
+private Q_SLOTS:
+    /** @return true if there were results to deliver. */
+    bool deliverResults();
+
+protected:
+    void run() override;
+
+private:
+    struct Job {
+        KSaneOption *option;
+        int          index;
+        bool         write;
+        QByteArray   data;
+        SANE_Status  status;
+        SANE_Int     info;
+    };
+
+    SANE_Handle    m_handle;
+    QMutex         m_deviceMutex;
+    QMutex         m_jobMutex;
+    QWaitCondition m_jobAdded;
+    QWaitCondition m_idle;
+    QList<Job>     m_jobs;
+    QList<Job>     m_results;
+    bool           m_busy;
+    bool           m_stop;
+    bool           m_resultsSignaled;
+};
+
+}  // NameSpace KSaneIface
+
+#endif
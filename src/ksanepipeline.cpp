@@ -0,0 +1,265 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#include "ksanepipeline.h"
+
+#include <QThreadPool>
+#include <QRunnable>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QMap>
+#include <QDebug>
+
+static const int DEFAULT_MAX_QUEUED_PAGES = 4;
+
+namespace KSaneIface
+{
+
+KSanePage::KSanePage()
+    : width(0),
+      height(0),
+      bytesPerLine(0),
+      format(0xFFFF),
+      dpi(0),
+      sequence(-1),
+      dropped(false)
+{
+}
+
+KSanePageStage::~KSanePageStage()
+{
+}
+
+KSaneRowStage::~KSaneRowStage()
+{
+}
+
+void KSaneRowStage::beginPage(const KSanePage &)
+{
+}
+
+void KSaneRowStage::endPage(KSanePage &)
+{
+}
+
+class PageTask : public QRunnable
+{
+public:
+    PageTask(KSanePipeline *pipeline, const QList<KSanePageStage *> &stages, const KSanePage &page)
+        : m_pipeline(pipeline), m_stages(stages), m_page(page) {}
+
+    void run() override
+    {
+        for (int i = 0; (i < m_stages.size()) && !m_page.dropped; i++) {
+            m_stages.at(i)->processPage(m_page);
+        }
+        QMetaObject::invokeMethod(m_pipeline, "pageFinished", Qt::QueuedConnection,
+                                  Q_ARG(KSaneIface::KSanePage, m_page));
+    }
+
+private:
+    KSanePipeline           *m_pipeline;
+    QList<KSanePageStage *>  m_stages;
+    KSanePage                m_page;
+};
+
+struct KSanePipeline::Private {
+    mutable QMutex          mutex;
+    QList<KSanePageStage *> pageStages;
+    QList<KSaneRowStage *>  rowStages;
+    // the row stages of the page that is read, changed with the mutex locked
+    QList<KSaneRowStage *>  activeRowStages;
+    // cleared row stages that are still used by the page that is read
+    QList<KSaneRowStage *>  retiredRowStages;
+    QThreadPool             pool;
+    int                     maxQueued;
+    int                     queued;
+    int                     nextSequence;
+    int                     nextDelivery;
+    QMap<int, KSanePage>    finished;
+};
+
+KSanePipeline::KSanePipeline(QObject *parent)
+    : QObject(parent), d(new Private)
+{
+    qRegisterMetaType<KSaneIface::KSanePage>();
+    d->maxQueued    = DEFAULT_MAX_QUEUED_PAGES;
+    d->queued       = 0;
+    d->nextSequence = 0;
+    d->nextDelivery = 0;
+}
+
+KSanePipeline::~KSanePipeline()
+{
+    d->pool.waitForDone();
+    qDeleteAll(d->pageStages);
+    qDeleteAll(d->rowStages);
+    qDeleteAll(d->retiredRowStages);
+    delete d;
+}
+
+void KSanePipeline::addPageStage(KSanePageStage *stage)
+{
+    QMutexLocker locker(&d->mutex);
+    d->pageStages.append(stage);
+}
+
+void KSanePipeline::addRowStage(KSaneRowStage *stage)
+{
+    QMutexLocker locker(&d->mutex);
+    d->rowStages.append(stage);
+}
+
+void KSanePipeline::clearStages()
+{
+    d->pool.waitForDone();
+    QMutexLocker locker(&d->mutex);
+    qDeleteAll(d->pageStages);
+    d->pageStages.clear();
+
+    // the scan thread can be in processRows() of the active stages
+    for (int i = 0; i < d->rowStages.size(); i++) {
+        if (d->activeRowStages.contains(d->rowStages.at(i))) {
+            d->retiredRowStages.append(d->rowStages.at(i));
+        } else {
+            delete d->rowStages.at(i);
+        }
+    }
+    d->rowStages.clear();
+}
+
+QList<KSaneRowStage *> KSanePipeline::rowStages() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->rowStages;
+}
+
+bool KSanePipeline::hasPageStages() const
+{
+    QMutexLocker locker(&d->mutex);
+    return !d->pageStages.isEmpty();
+}
+
+void KSanePipeline::setMaxThreadCount(int count)
+{
+    d->pool.setMaxThreadCount(qMax(1, count));
+}
+
+int KSanePipeline::maxThreadCount() const
+{
+    return d->pool.maxThreadCount();
+}
+
+void KSanePipeline::setMaxQueuedPages(int count)
+{
+    bool wasFull = isFull();
+    d->maxQueued = qMax(1, count);
+    if (wasFull && !isFull()) {
+        emit ready();
+    }
+}
+
+int KSanePipeline::maxQueuedPages() const
+{
+    return d->maxQueued;
+}
+
+int KSanePipeline::queuedPages() const
+{
+    return d->queued;
+}
+
+bool KSanePipeline::isFull() const
+{
+    return d->queued >= d->maxQueued;
+}
+
+void KSanePipeline::beginRows(const KSanePage &page)
+{
+    QMutexLocker locker(&d->mutex);
+    // a cancelled page does not call endRows()
+    qDeleteAll(d->retiredRowStages);
+    d->retiredRowStages.clear();
+    d->activeRowStages = d->rowStages;
+    locker.unlock();
+
+    for (int i = 0; i < d->activeRowStages.size(); i++) {
+        d->activeRowStages.at(i)->beginPage(page);
+    }
+}
+
+void KSanePipeline::processRows(char *rows, int firstRow, int rowCount, int bytesPerLine)
+{
+    for (int i = 0; i < d->activeRowStages.size(); i++) {
+        d->activeRowStages.at(i)->processRows(rows, firstRow, rowCount, bytesPerLine);
+    }
+}
+
+void KSanePipeline::endRows(KSanePage &page)
+{
+    for (int i = 0; i < d->activeRowStages.size(); i++) {
+        d->activeRowStages.at(i)->endPage(page);
+    }
+
+    QMutexLocker locker(&d->mutex);
+    d->activeRowStages.clear();
+    qDeleteAll(d->retiredRowStages);
+    d->retiredRowStages.clear();
+}
+
+void KSanePipeline::queuePage(const KSanePage &page)
+{
+    KSanePage queuedPage = page;
+    queuedPage.sequence = d->nextSequence++;
+    d->queued++;
+
+    QMutexLocker locker(&d->mutex);
+    d->pool.start(new PageTask(this, d->pageStages, queuedPage));
+}
+
+void KSanePipeline::waitForDone()
+{
+    d->pool.waitForDone();
+}
+
+void KSanePipeline::pageFinished(const KSanePage &page)
+{
+    bool wasFull = isFull();
+    d->queued--;
+
+    // a page can be finished before a page that was queued earlier
+    d->finished.insert(page.sequence, page);
+    while (d->finished.contains(d->nextDelivery)) {
+        KSanePage next = d->finished.take(d->nextDelivery);
+        d->nextDelivery++;
+        emit pageProcessed(next);
+    }
+
+    if (wasFull && !isFull()) {
+        emit ready();
+    }
+}
+
+}  // NameSpace KSaneIface
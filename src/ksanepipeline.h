@@ -0,0 +1,182 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#ifndef KSANE_PIPELINE_H
+#define KSANE_PIPELINE_H
+
+#include "ksanecore_export.h"
+
+#include <QObject>
+#include <QByteArray>
+#include <QVariantMap>
+#include <QList>
+#include <QMetaType>
+
+namespace KSaneIface
+{
+
+/** One scanned page on its way through a KSanePipeline. */
+struct KSanePage {
+    KSanePage();
+
+    QByteArray  data;           ///< the image data, empty while the page is read
+    int         width;          ///< in pixels
+    int         height;         ///< in pixels, -1 while an unknown line count is read
+    int         bytesPerLine;
+    int         format;         ///< KSaneCore::ImageFormat (same values as KSaneWidget::ImageFormat)
+    int         dpi;            ///< 0 if the resolution is not known
+    int         sequence;       ///< the number of the page in the pipeline
+    bool        dropped;        ///< a dropped page is not delivered and not processed
+    QVariantMap properties;     ///< the results of the stages
+};
+
+/**
+ * A stage that processes whole pages. It is called in a worker thread of the pipeline
+ * after the page is delivered with imageReady(). Several pages can be processed at the
+ * same time, so processPage() must be reentrant.
+ */
+class KSANECORE_EXPORT KSanePageStage
+{
+public:
+    virtual ~KSanePageStage();
+
+    /** Process the page. The stage can change the data, add properties or drop the page,
+     * in which case the following stages are not called. */
+    virtual void processPage(KSanePage &page) = 0;
+};
+
+/**
+ * A stage that processes the rows of a page while they are read, so that no extra pass
+ * over the data is needed. The rows are passed in blocks in the scan thread. Rows are
+ * only passed for pages that are sent in one frame. The rows of a three-pass color scan
+ * are passed in one block after the last frame.
+ */
+class KSANECORE_EXPORT KSaneRowStage
+{
+public:
+    virtual ~KSaneRowStage();
+
+    /** This is called in the scan thread before the first rows of a page.
+     * The data of the page is empty. */
+    virtual void beginPage(const KSanePage &page);
+
+    /** Process a block of rows. The rows can be changed in place.
+     * @param rows points to the first row of the block.
+     * @param firstRow is the number of the first row in the page.
+     * @param rowCount is the number of rows in the block.
+     * @param bytesPerLine is the distance between two rows in rows. */
+    virtual void processRows(char *rows, int firstRow, int rowCount, int bytesPerLine) = 0;
+
+    /** This is called in the thread of the pipeline when the page is read. The stage can
+     * add its results to the properties of the page or drop it. */
+    virtual void endPage(KSanePage &page);
+};
+
+/**
+ * This class runs the stages that post-process the scanned pages. The page stages run in a
+ * thread pool of the pipeline, so a slow stage does not block the GUI or the scan. The
+ * pages are delivered with pageProcessed() in the order they were queued.
+ *
+ * The number of pages in the pipeline is limited. When it is full, a batch scan waits
+ * with the next page until a page is processed.
+ */
+class KSANECORE_EXPORT KSanePipeline : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit KSanePipeline(QObject *parent = nullptr);
+    /** Wait for the queued pages and delete the stages. */
+    ~KSanePipeline();
+
+    /** Add a page stage. The stages are called in the order they were added.
+     * The pipeline takes the ownership of the stage. */
+    void addPageStage(KSanePageStage *stage);
+
+    /** Add a row stage. It is used from the next scan.
+     * The pipeline takes the ownership of the stage. */
+    void addRowStage(KSaneRowStage *stage);
+
+    /** Wait for the queued pages and delete all stages. The row stages of a page that is
+     * read are used until the page is done and deleted in endRows(). */
+    void clearStages();
+
+    /** @return the row stages. Used by the scan thread. */
+    QList<KSaneRowStage *> rowStages() const;
+
+    /** @return true if there are page stages. */
+    bool hasPageStages() const;
+
+    /** Set the number of worker threads (default: the number of CPU cores). */
+    void setMaxThreadCount(int count);
+    int maxThreadCount() const;
+
+    /** Set the number of pages that can be queued or processed at the same time (default 4). */
+    void setMaxQueuedPages(int count);
+    int maxQueuedPages() const;
+
+    /** @return the number of pages that are queued or processed. */
+    int queuedPages() const;
+
+    /** @return true if no more pages should be queued. */
+    bool isFull() const;
+
+    /** Call beginPage() of the row stages. */
+    void beginRows(const KSanePage &page);
+
+    /** Pass rows to the row stages. */
+    void processRows(char *rows, int firstRow, int rowCount, int bytesPerLine);
+
+    /** Call endPage() of the row stages. */
+    void endRows(KSanePage &page);
+
+    /** Queue a page for the page stages. The page is queued also if the pipeline is full.
+     * Without page stages the page is delivered from the event loop. */
+    void queuePage(const KSanePage &page);
+
+    /** Block until all queued pages are processed. The pages are delivered later. */
+    void waitForDone();
+
+Q_SIGNALS:
+    /** This signal is emitted when the page stages are done with a page. The pages are
+     * delivered in the order they were queued. A dropped page is also delivered. */
+    void pageProcessed(const KSaneIface::KSanePage &page);
+
+    /** This signal is emitted when a full pipeline can accept pages again. */
+    void ready();
+
+private Q_SLOTS:
+    void pageFinished(const KSaneIface::KSanePage &page);
+
+private:
+    struct Private;
+    Private *const d;
+};
+
+}  // NameSpace KSaneIface
+
+Q_DECLARE_METATYPE(KSaneIface::KSanePage)
+
+#endif // KSANE_PIPELINE_H
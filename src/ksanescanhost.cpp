@@ -0,0 +1,275 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+// This helper owns the SANE handle of a KSaneCore in isolation mode, so that a backend
+// that crashes or hangs only takes this process down.
+//
+// The commands are read from stdin, one per line with tab separated percent encoded
+// fields. Every command except "scan" is answered with a line that starts with "ok" or
+// "error". "scan" writes one page into the shared memory ring (see ksanescanring.h).
+
+#include "ksaneauth.h"
+#include "ksaneoptionvalue.h"
+#include "ksanescanring.h"
+
+#include <QSharedMemory>
+#include <QSystemSemaphore>
+#include <QByteArray>
+#include <QStringList>
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace KSaneIface;
+
+static const int READ_CHUNK_SIZE  = 100000;
+static const int MAX_COMMAND_SIZE = 65536;
+
+static void reply(bool ok, const QStringList &fields = QStringList())
+{
+    QByteArray line = ok ? "ok" : "error";
+    for (int i = 0; i < fields.size(); i++) {
+        line += '\t';
+        line += fields.at(i).toUtf8().toPercentEncoding();
+    }
+    line += '\n';
+    fwrite(line.constData(), 1, line.size(), stdout);
+    fflush(stdout);
+}
+
+class RingWriter
+{
+public:
+    RingWriter(void *ring, QSystemSemaphore *dataSem, QSystemSemaphore *spaceSem)
+        : m_header(static_cast<ScanRing::RingHeader *>(ring)),
+          m_data(ScanRing::dataArea(ring)),
+          m_dataSem(dataSem),
+          m_spaceSem(spaceSem),
+          m_reserved(0)
+    {}
+
+    bool cancelled() const
+    {
+        return m_header->cancel.loadAcquire() != 0;
+    }
+
+    /** Wait until there is contiguous space for a record with at least minLength bytes.
+     * @return the start of the payload. length is set to the available bytes. */
+    char *reserve(quint32 minLength, quint32 &length)
+    {
+        const quint64 size = m_header->dataSize;
+        for (;;) {
+            const quint64 writePos = m_header->writePos.loadAcquire();
+            const quint64 readPos = m_header->readPos.loadAcquire();
+            const quint64 space = size - (writePos - readPos);
+            const quint64 offset = writePos % size;
+            const quint64 contiguous = size - offset;
+
+            if (contiguous < ScanRing::recordSize(minLength)) {
+                if (space >= contiguous) {
+                    // continue at the start of the ring
+                    ScanRing::RecordHeader *pad = reinterpret_cast<ScanRing::RecordHeader *>(m_data + offset);
+                    pad->type = ScanRing::RECORD_PAD;
+                    pad->length = contiguous - sizeof(ScanRing::RecordHeader);
+                    m_header->writePos.storeRelease(writePos + contiguous);
+                    wakeReader();
+                    continue;
+                }
+            } else if (space >= ScanRing::recordSize(minLength)) {
+                length = qMin(space, contiguous) - sizeof(ScanRing::RecordHeader);
+                m_reserved = offset;
+                return m_data + offset + sizeof(ScanRing::RecordHeader);
+            }
+            // the reader is behind, wait until it has read a record
+            m_header->writerWaiting.fetchAndStoreOrdered(1);
+            if (m_header->readPos.loadAcquire() == readPos) {
+                m_spaceSem->acquire();
+            }
+        }
+    }
+
+    void commit(quint32 type, quint32 length)
+    {
+        ScanRing::RecordHeader *record = reinterpret_cast<ScanRing::RecordHeader *>(m_data + m_reserved);
+        record->type = type;
+        record->length = length;
+        m_header->writePos.storeRelease(m_header->writePos.loadAcquire() + ScanRing::recordSize(length));
+        wakeReader();
+    }
+
+    void write(quint32 type, const void *payload, quint32 length)
+    {
+        quint32 available;
+        memcpy(reserve(length, available), payload, length);
+        commit(type, length);
+    }
+
+private:
+    void wakeReader()
+    {
+        if (m_header->readerWaiting.fetchAndStoreOrdered(0) != 0) {
+            m_dataSem->release();
+        }
+    }
+
+    ScanRing::RingHeader *m_header;
+    char                 *m_data;
+    QSystemSemaphore     *m_dataSem;
+    QSystemSemaphore     *m_spaceSem;
+    quint64               m_reserved;
+};
+
+static SANE_Status scanPage(SANE_Handle handle, RingWriter &ring)
+{
+    SANE_Parameters params;
+    SANE_Status status = sane_start(handle);
+    if (status == SANE_STATUS_GOOD) {
+        status = sane_get_parameters(handle, &params);
+    }
+    if ((status == SANE_STATUS_GOOD) &&
+            (params.format != SANE_FRAME_GRAY) && (params.format != SANE_FRAME_RGB)) {
+        // the three pass frames are only combined by KSaneScanThread
+        status = SANE_STATUS_UNSUPPORTED;
+    }
+
+    if (status == SANE_STATUS_GOOD) {
+        ScanRing::PageInfo info;
+        info.format        = params.format;
+        info.pixelsPerLine = params.pixels_per_line;
+        info.bytesPerLine  = params.bytes_per_line;
+        info.lines         = params.lines;
+        info.depth         = params.depth;
+        ring.write(ScanRing::RECORD_PAGE, &info, sizeof(info));
+    }
+
+    while (status == SANE_STATUS_GOOD) {
+        if (ring.cancelled()) {
+            status = SANE_STATUS_CANCELLED;
+            break;
+        }
+        // read directly into the ring
+        quint32 length;
+        char *data = ring.reserve(1, length);
+        SANE_Int readBytes = 0;
+        status = sane_read(handle, reinterpret_cast<SANE_Byte *>(data),
+                           qMin<quint32>(length, READ_CHUNK_SIZE), &readBytes);
+        if ((readBytes > 0) && ((status == SANE_STATUS_GOOD) || (status == SANE_STATUS_EOF))) {
+            ring.commit(ScanRing::RECORD_DATA, readBytes);
+        }
+    }
+
+    if (status == SANE_STATUS_EOF) {
+        status = SANE_STATUS_GOOD;
+    } else {
+        sane_cancel(handle);
+    }
+
+    const qint32 endStatus = status;
+    ring.write(ScanRing::RECORD_END, &endStatus, sizeof(endStatus));
+    return status;
+}
+
+int main(int argc, char *argv[])
+{
+    SANE_Int    version;
+    SANE_Status status;
+    SANE_Handle handle = nullptr;
+    static char line[MAX_COMMAND_SIZE];
+
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <shared memory key>\n", argv[0]);
+        return 1;
+    }
+
+    const QString ringKey = QString::fromLocal8Bit(argv[1]);
+    QSharedMemory ring(ringKey);
+    if (!ring.attach()) {
+        fprintf(stderr, "Could not attach the scan ring: %s\n", ring.errorString().toLocal8Bit().constData());
+        return 1;
+    }
+    // the semaphores are created by the reader
+    QSystemSemaphore dataSem(ScanRing::dataSemaphoreKey(ringKey), 0, QSystemSemaphore::Open);
+    QSystemSemaphore spaceSem(ScanRing::spaceSemaphoreKey(ringKey), 0, QSystemSemaphore::Open);
+    RingWriter writer(ring.data(), &dataSem, &spaceSem);
+
+    status = sane_init(&version, &KSaneAuth::authorization);
+    if (status != SANE_STATUS_GOOD) {
+        fprintf(stderr, "sane_init() failed: %s\n", sane_strstatus(status));
+        return 1;
+    }
+
+    while (fgets(line, sizeof(line), stdin) != nullptr) {
+        QByteArray input(line);
+        if (input.endsWith('\n')) {
+            input.chop(1);
+        }
+        const QList<QByteArray> encoded = input.split('\t');
+        QStringList fields;
+        for (int i = 1; i < encoded.size(); i++) {
+            fields << QString::fromUtf8(QByteArray::fromPercentEncoding(encoded.at(i)));
+        }
+        const QByteArray command = encoded.at(0);
+
+        if ((command == "auth") && (fields.size() == 3)) {
+            KSaneAuth::getInstance()->setDeviceAuth(fields.at(0), fields.at(1), fields.at(2));
+            reply(true);
+        } else if ((command == "open") && (fields.size() == 1) && (handle == nullptr)) {
+            status = sane_open(fields.at(0).toLatin1().constData(), &handle);
+            if (status != SANE_STATUS_GOOD) {
+                handle = nullptr;
+                reply(false, QStringList(QString::fromUtf8(sane_strstatus(status))));
+            } else {
+                reply(true);
+            }
+        } else if (handle == nullptr) {
+            reply(false, QStringList(QStringLiteral("No device is open")));
+        } else if (command == "names") {
+            reply(true, KSaneOptionValue::optionNames(handle));
+        } else if ((command == "get") && (fields.size() == 1)) {
+            QString value;
+            const bool ok = KSaneOptionValue::getValue(handle, fields.at(0), value);
+            reply(ok, ok ? QStringList(value) : QStringList());
+        } else if ((command == "set") && (fields.size() == 2)) {
+            reply(KSaneOptionValue::setValue(handle, fields.at(0), fields.at(1)));
+        } else if (command == "scan") {
+            // the reader gets the result from the ring
+            scanPage(handle, writer);
+        } else if (command == "cancel") {
+            sane_cancel(handle);
+            reply(true);
+        } else if (command == "close") {
+            break;
+        } else {
+            reply(false, QStringList(QStringLiteral("Unknown command")));
+        }
+    }
+
+    if (handle != nullptr) {
+        sane_close(handle);
+    }
+    sane_exit();
+    delete KSaneAuth::getInstance();
+    return 0;
+}
@@ -0,0 +1,524 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#include "ksanescanhostclient.h"
+
+#include "ksaneauth.h"
+#include "ksanepipeline.h"
+#include "ksanescansession.h"
+
+#include <QCoreApplication>
+#include <QAtomicInt>
+#include <QDebug>
+
+#include <string.h>
+#include <new>
+
+// the lamp of some scanners warms up for a long time before the first data
+static const int DEFAULT_HOST_TIMEOUT = 60000;
+static const int PROGRESS_CHECK_INTERVAL = 1000;
+
+namespace KSaneIface
+{
+static QAtomicInt s_ringCount;
+
+static_assert(sizeof(ScanRing::RingHeader) <= ScanRing::HEADER_SIZE, "the ring header does not fit");
+
+static SANE_Parameters toParameters(const ScanRing::PageInfo &info)
+{
+    SANE_Parameters params;
+    params.format          = (SANE_Frame)info.format;
+    params.last_frame      = SANE_TRUE;
+    params.bytes_per_line  = info.bytesPerLine;
+    params.pixels_per_line = info.pixelsPerLine;
+    params.lines           = info.lines;
+    params.depth           = info.depth;
+    return params;
+}
+
+KSaneScanRingReader::KSaneScanRingReader(void *ring, QSystemSemaphore *dataSem, QSystemSemaphore *spaceSem)
+    : QThread(),
+      m_header(static_cast<ScanRing::RingHeader *>(ring)),
+      m_data(ScanRing::dataArea(ring)),
+      m_dataSem(dataSem),
+      m_spaceSem(spaceSem),
+      m_pipeline(nullptr),
+      m_rowsFed(0),
+      m_pageStatus(SANE_STATUS_GOOD)
+{
+    memset(&m_pageInfo, 0, sizeof(m_pageInfo));
+}
+
+void KSaneScanRingReader::stop()
+{
+    m_stop.storeRelease(1);
+    // wake the reader if it waits for data
+    m_dataSem->release();
+}
+
+QByteArray &KSaneScanRingReader::pageData()
+{
+    return m_pageData;
+}
+
+ScanRing::PageInfo KSaneScanRingReader::pageInfo() const
+{
+    QMutexLocker locker(&m_pageInfoMutex);
+    return m_pageInfo;
+}
+
+qint32 KSaneScanRingReader::pageStatus() const
+{
+    return m_pageStatus;
+}
+
+qint64 KSaneScanRingReader::bytesRead() const
+{
+    return m_bytesRead.loadAcquire();
+}
+
+void KSaneScanRingReader::reset(KSanePipeline *pipeline)
+{
+    m_pipeline = pipeline;
+    m_rowsFed = 0;
+    m_pageData.clear();
+    m_pageInfoMutex.lock();
+    memset(&m_pageInfo, 0, sizeof(m_pageInfo));
+    m_pageInfoMutex.unlock();
+    m_pageStatus = SANE_STATUS_IO_ERROR;
+    m_bytesRead.storeRelease(0);
+    m_stop.storeRelease(0);
+}
+
+void KSaneScanRingReader::run()
+{
+    const quint64 size = m_header->dataSize;
+
+    while (!m_stop.loadAcquire()) {
+        const quint64 readPos = m_header->readPos.loadAcquire();
+        if (m_header->writePos.loadAcquire() == readPos) {
+            // the writer releases the semaphore after the next record
+            m_header->readerWaiting.fetchAndStoreOrdered(1);
+            if (m_header->writePos.loadAcquire() == readPos) {
+                m_dataSem->acquire();
+            }
+            continue;
+        }
+
+        // a record is never split at the end of the ring
+        ScanRing::RecordHeader *record = reinterpret_cast<ScanRing::RecordHeader *>(m_data + (readPos % size));
+        char *payload = reinterpret_cast<char *>(record) + sizeof(ScanRing::RecordHeader);
+        bool pageEnd = false;
+
+        switch (record->type) {
+        case ScanRing::RECORD_PAGE: {
+            ScanRing::PageInfo info;
+            memcpy(&info, payload, sizeof(info));
+            m_pageInfoMutex.lock();
+            m_pageInfo = info;
+            m_pageInfoMutex.unlock();
+            if (info.lines > 0) {
+                m_pageData.reserve(info.lines * info.bytesPerLine);
+            }
+            if (m_pipeline != nullptr) {
+                m_pipeline->beginRows(KSaneScanSession::pageFromParameters(toParameters(info), 0));
+            }
+            break;
+        }
+        case ScanRing::RECORD_DATA:
+            appendData(payload, record->length);
+            m_bytesRead.fetchAndAddRelease(record->length);
+            break;
+        case ScanRing::RECORD_END:
+            memcpy(&m_pageStatus, payload, sizeof(m_pageStatus));
+            pageEnd = true;
+            break;
+        default:
+            break;
+        }
+        m_header->readPos.storeRelease(readPos + ScanRing::recordSize(record->length));
+        if (m_header->writerWaiting.fetchAndStoreOrdered(0) != 0) {
+            m_spaceSem->release();
+        }
+
+        if (pageEnd) {
+            return;
+        }
+    }
+}
+
+void KSaneScanRingReader::appendData(char *data, int length)
+{
+    // only this thread writes the page info
+    const int bytesPerLine = m_pageInfo.bytesPerLine;
+    if ((m_pipeline == nullptr) || (bytesPerLine <= 0)) {
+        // the only copy of the data in this process
+        m_pageData.append(data, length);
+        return;
+    }
+
+    // complete the row that the previous record has started
+    const int started = m_pageData.size() - (m_rowsFed * bytesPerLine);
+    if (started > 0) {
+        const int count = qMin(bytesPerLine - started, length);
+        m_pageData.append(data, count);
+        data += count;
+        length -= count;
+        if (started + count == bytesPerLine) {
+            m_pipeline->processRows(m_pageData.data() + (m_rowsFed * bytesPerLine), m_rowsFed, 1, bytesPerLine);
+            m_rowsFed++;
+        }
+    }
+
+    // the complete rows are processed in the ring, so they are still copied only once
+    const int rows = length / bytesPerLine;
+    if (rows > 0) {
+        m_pipeline->processRows(data, m_rowsFed, rows, bytesPerLine);
+        m_rowsFed += rows;
+    }
+    m_pageData.append(data, length);
+}
+
+KSaneScanHostClient::KSaneScanHostClient(QObject *parent)
+    : QObject(parent),
+      m_host(nullptr),
+      m_dataSem(nullptr),
+      m_spaceSem(nullptr),
+      m_reader(nullptr),
+      m_pipeline(nullptr),
+      m_lastBytesRead(0),
+      m_timeout(DEFAULT_HOST_TIMEOUT),
+      m_scanning(false),
+      m_stalled(false)
+{
+    m_progressTmr.setSingleShot(false);
+    m_progressTmr.setInterval(PROGRESS_CHECK_INTERVAL);
+    connect(&m_progressTmr, SIGNAL(timeout()), this, SLOT(checkProgress()));
+}
+
+KSaneScanHostClient::~KSaneScanHostClient()
+{
+    close();
+}
+
+void KSaneScanHostClient::setTimeout(int timeoutMsec)
+{
+    m_timeout = qMax(1, timeoutMsec);
+}
+
+void KSaneScanHostClient::setPipeline(KSanePipeline *pipeline)
+{
+    m_pipeline = pipeline;
+}
+
+bool KSaneScanHostClient::open(const QString &deviceName)
+{
+    if (m_host != nullptr) {
+        return false;
+    }
+    close();
+    m_errorString.clear();
+    m_stalled = false;
+
+    m_ring.setKey(QStringLiteral("ksane-scan-host-%1-%2")
+                  .arg(QCoreApplication::applicationPid())
+                  .arg(s_ringCount.fetchAndAddRelaxed(1)));
+    if (!m_ring.create(ScanRing::HEADER_SIZE + ScanRing::DEFAULT_SIZE)) {
+        qDebug() << "Could not create the scan ring" << m_ring.errorString();
+        return false;
+    }
+    ScanRing::RingHeader *header = new (m_ring.data()) ScanRing::RingHeader;
+    header->writePos.storeRelease(0);
+    header->readPos.storeRelease(0);
+    header->cancel.storeRelease(0);
+    header->readerWaiting.storeRelease(0);
+    header->writerWaiting.storeRelease(0);
+    header->dataSize = ScanRing::DEFAULT_SIZE;
+    // created here, so that a semaphore left by a killed host starts at zero again
+    m_dataSem = new QSystemSemaphore(ScanRing::dataSemaphoreKey(m_ring.key()), 0, QSystemSemaphore::Create);
+    m_spaceSem = new QSystemSemaphore(ScanRing::spaceSemaphoreKey(m_ring.key()), 0, QSystemSemaphore::Create);
+    m_reader = new KSaneScanRingReader(m_ring.data(), m_dataSem, m_spaceSem);
+    connect(m_reader, SIGNAL(finished()), this, SLOT(readerDone()));
+
+    m_host = new QProcess(this);
+    m_host->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    connect(m_host, SIGNAL(finished(int,QProcess::ExitStatus)), this, SLOT(hostFinished()));
+    m_host->start(QStringLiteral(KSANE_SCAN_HOST), QStringList(m_ring.key()));
+    if (!m_host->waitForStarted(m_timeout)) {
+        qDebug() << "Could not start" << KSANE_SCAN_HOST << m_host->errorString();
+        close();
+        return false;
+    }
+
+    // the host can not ask for the credentials
+    SANE_Char username[SANE_MAX_USERNAME_LEN];
+    SANE_Char password[SANE_MAX_PASSWORD_LEN];
+    username[0] = 0;
+    password[0] = 0;
+    KSaneAuth::authorization(deviceName.toUtf8().constData(), username, password);
+    if (username[0] != 0) {
+        QStringList auth;
+        auth << QStringLiteral("auth") << deviceName
+             << QString::fromLocal8Bit(username) << QString::fromLocal8Bit(password);
+        request(auth);
+    }
+
+    QStringList openCommand;
+    openCommand << QStringLiteral("open") << deviceName;
+    QStringList reply;
+    if (!request(openCommand, &reply)) {
+        qDebug() << "The scan host could not open" << deviceName << reply;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void KSaneScanHostClient::close()
+{
+    if (m_host != nullptr) {
+        disconnect(m_host, nullptr, this, nullptr);
+        if (m_host->state() != QProcess::NotRunning) {
+            const bool scanning = isScanning();
+            if (!scanning) {
+                m_host->write("close\n");
+                m_host->closeWriteChannel();
+            }
+            if (scanning || !m_host->waitForFinished(m_timeout)) {
+                m_host->kill();
+                m_host->waitForFinished(1000);
+            }
+        }
+        delete m_host;
+        m_host = nullptr;
+    }
+    if (m_reader != nullptr) {
+        disconnect(m_reader, nullptr, this, nullptr);
+        m_reader->stop();
+        m_reader->wait();
+        delete m_reader;
+        m_reader = nullptr;
+    }
+    delete m_dataSem;
+    m_dataSem = nullptr;
+    delete m_spaceSem;
+    m_spaceSem = nullptr;
+    m_progressTmr.stop();
+    m_scanning = false;
+    if (m_ring.isAttached()) {
+        m_ring.detach();
+    }
+}
+
+bool KSaneScanHostClient::request(const QStringList &fields, QStringList *replyFields)
+{
+    if ((m_host == nullptr) || isScanning()) {
+        return false;
+    }
+
+    QByteArray line = fields.at(0).toLatin1();
+    for (int i = 1; i < fields.size(); i++) {
+        line += '\t';
+        line += fields.at(i).toUtf8().toPercentEncoding();
+    }
+    line += '\n';
+    m_host->write(line);
+
+    QElapsedTimer timer;
+    timer.start();
+    while (!m_host->canReadLine()) {
+        const qint64 remaining = m_timeout - timer.elapsed();
+        if ((remaining <= 0) || !m_host->waitForReadyRead(remaining)) {
+            stopHost(QStringLiteral("The scan host did not answer a command"));
+            return false;
+        }
+    }
+
+    QByteArray reply = m_host->readLine();
+    reply.chop(1);
+    const QList<QByteArray> encoded = reply.split('\t');
+    if (replyFields != nullptr) {
+        replyFields->clear();
+        for (int i = 1; i < encoded.size(); i++) {
+            *replyFields << QString::fromUtf8(QByteArray::fromPercentEncoding(encoded.at(i)));
+        }
+    }
+    return encoded.at(0) == "ok";
+}
+
+QStringList KSaneScanHostClient::optionNames()
+{
+    QStringList names;
+    if (!request(QStringList(QStringLiteral("names")), &names)) {
+        names.clear();
+    }
+    return names;
+}
+
+bool KSaneScanHostClient::getOptionValue(const QString &name, QString &value)
+{
+    QStringList command;
+    command << QStringLiteral("get") << name;
+    QStringList reply;
+    if (!request(command, &reply) || reply.isEmpty()) {
+        return false;
+    }
+    value = reply.at(0);
+    return true;
+}
+
+bool KSaneScanHostClient::setOptionValue(const QString &name, const QString &value)
+{
+    QStringList command;
+    command << QStringLiteral("set") << name << value;
+    return request(command);
+}
+
+void KSaneScanHostClient::startScan()
+{
+    if ((m_host == nullptr) || m_scanning) {
+        return;
+    }
+    static_cast<ScanRing::RingHeader *>(m_ring.data())->cancel.storeRelease(0);
+    m_scanning = true;
+    m_lastBytesRead = 0;
+    m_lastProgress.start();
+    m_reader->reset(m_pipeline);
+    m_reader->start();
+    m_host->write("scan\n");
+    m_progressTmr.start();
+}
+
+void KSaneScanHostClient::endScan()
+{
+    request(QStringList(QStringLiteral("cancel")));
+}
+
+void KSaneScanHostClient::cancelScan()
+{
+    if (m_scanning) {
+        static_cast<ScanRing::RingHeader *>(m_ring.data())->cancel.storeRelease(1);
+    }
+}
+
+bool KSaneScanHostClient::isScanning() const
+{
+    // the host is ready for commands as soon as the reader has the end of the page
+    return m_scanning && m_reader->isRunning();
+}
+
+bool KSaneScanHostClient::isAlive() const
+{
+    return (m_host != nullptr) && (m_host->state() != QProcess::NotRunning);
+}
+
+int KSaneScanHostClient::scanProgress() const
+{
+    if (m_reader == nullptr) {
+        return 0;
+    }
+    const ScanRing::PageInfo info = m_reader->pageInfo();
+    const qint64 size = (qint64)info.lines * info.bytesPerLine;
+    if (size <= 0) {
+        return 0;
+    }
+    return (int)qMin<qint64>(100, (m_reader->bytesRead() * 100) / size);
+}
+
+QByteArray &KSaneScanHostClient::pageData()
+{
+    return m_reader->pageData();
+}
+
+ScanRing::PageInfo KSaneScanHostClient::pageInfo() const
+{
+    return m_reader->pageInfo();
+}
+
+SANE_Parameters KSaneScanHostClient::pageParameters() const
+{
+    return toParameters(m_reader->pageInfo());
+}
+
+QString KSaneScanHostClient::errorString() const
+{
+    return m_errorString;
+}
+
+bool KSaneScanHostClient::stalled() const
+{
+    return m_stalled;
+}
+
+void KSaneScanHostClient::checkProgress()
+{
+    const qint64 bytesRead = m_reader->bytesRead();
+    if (bytesRead != m_lastBytesRead) {
+        m_lastBytesRead = bytesRead;
+        m_lastProgress.start();
+        return;
+    }
+    if (m_lastProgress.elapsed() > m_timeout) {
+        qDebug() << "The scan host did not deliver data for" << m_timeout << "ms";
+        m_stalled = true;
+        stopHost(QStringLiteral("The scan host did not deliver data"));
+    }
+}
+
+void KSaneScanHostClient::hostFinished()
+{
+    qDebug() << "The scan host stopped" << m_host->exitStatus() << m_host->exitCode();
+    stopHost(QStringLiteral("The scan host stopped unexpectedly"));
+}
+
+void KSaneScanHostClient::stopHost(const QString &reason)
+{
+    m_errorString = reason;
+    if (m_host != nullptr) {
+        disconnect(m_host, nullptr, this, nullptr);
+        m_host->kill();
+        m_host->waitForFinished(1000);
+        // this can be called from a signal of the process
+        m_host->deleteLater();
+        m_host = nullptr;
+    }
+    // readerDone() reports the page with the error
+    m_reader->stop();
+}
+
+void KSaneScanHostClient::readerDone()
+{
+    if (!m_scanning) {
+        return;
+    }
+    m_progressTmr.stop();
+    m_scanning = false;
+
+    // the device must be opened again if the host is gone
+    const int status = m_errorString.isEmpty() ? m_reader->pageStatus() : (int)SANE_STATUS_IO_ERROR;
+    emit pageDone(status);
+}
+
+}  // NameSpace KSaneIface
@@ -0,0 +1,181 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#ifndef KSANE_SCAN_HOST_CLIENT_H
+#define KSANE_SCAN_HOST_CLIENT_H
+
+#include "ksanescanring.h"
+
+// Sane includes
+extern "C"
+{
+#include <sane/saneopts.h>
+#include <sane/sane.h>
+}
+
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include <QProcess>
+#include <QSharedMemory>
+#include <QSystemSemaphore>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QByteArray>
+#include <QStringList>
+
+namespace KSaneIface
+{
+
+class KSanePipeline;
+
+/**
+ * This thread copies the records of one page from the scan ring to the page data.
+ * The complete rows in a record are passed to the row stages of the pipeline in the
+ * ring, before they are copied, so the stages see the page while it is read.
+ */
+class KSaneScanRingReader : public QThread
+{
+    Q_OBJECT
+
+public:
+    KSaneScanRingReader(void *ring, QSystemSemaphore *dataSem, QSystemSemaphore *spaceSem);
+
+    /** Prepare the reading of the next page. This must be called before start().
+     * @param pipeline gets the rows of the page or is nullptr. */
+    void reset(KSanePipeline *pipeline);
+
+    void run() override;
+
+    /** Stop reading, for example when the host process is gone. */
+    void stop();
+
+    QByteArray &pageData();
+    ScanRing::PageInfo pageInfo() const;
+    qint32 pageStatus() const;
+
+    /** @return the number of bytes read from the ring since the start of the page. */
+    qint64 bytesRead() const;
+
+private:
+    void appendData(char *data, int length);
+
+    ScanRing::RingHeader *m_header;
+    char                 *m_data;
+    QSystemSemaphore     *m_dataSem;
+    QSystemSemaphore     *m_spaceSem;
+    KSanePipeline        *m_pipeline;
+    int                   m_rowsFed;
+    QByteArray            m_pageData;
+    // the page info is read by the GUI thread for the progress
+    mutable QMutex        m_pageInfoMutex;
+    ScanRing::PageInfo    m_pageInfo;
+    qint32                m_pageStatus;
+    QAtomicInteger<qint64> m_bytesRead;
+    QAtomicInt            m_stop;
+};
+
+/**
+ * This class runs the scan host process (ksane_scan_host) that owns the SANE handle of a
+ * device in isolation mode. The options are set with commands on the stdin of the host and
+ * the scanned data is read from a shared memory ring. A host that does not answer or does
+ * not deliver data for the timeout is killed.
+ */
+class KSaneScanHostClient : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit KSaneScanHostClient(QObject *parent = nullptr);
+    ~KSaneScanHostClient();
+
+    void setTimeout(int timeoutMsec);
+
+    /** Set the pipeline whose row stages get the rows while a page is read. */
+    void setPipeline(KSanePipeline *pipeline);
+
+    /** Start the host and open the device. The credentials set with
+     * KSaneAuth::setDeviceAuth() are passed to the host. */
+    bool open(const QString &deviceName);
+    void close();
+
+    QStringList optionNames();
+    bool getOptionValue(const QString &name, QString &value);
+    bool setOptionValue(const QString &name, const QString &value);
+
+    /** Scan one page. pageDone() is emitted when the page is read. */
+    void startScan();
+    /** Call sane_cancel() in the host after the last page of a scan. */
+    void endScan();
+    /** Cancel the page that is scanned. */
+    void cancelScan();
+    bool isScanning() const;
+    int scanProgress() const;
+
+    /** @return false if the host process was stopped and the device must be opened again. */
+    bool isAlive() const;
+
+    QByteArray &pageData();
+    ScanRing::PageInfo pageInfo() const;
+    /** @return the parameters of the page that is read. */
+    SANE_Parameters pageParameters() const;
+
+    /** @return the reason why the host was stopped or an empty string. The reason is
+     * not translated and only meant for debug output. */
+    QString errorString() const;
+    /** @return true if the host was stopped because it did not deliver data. */
+    bool stalled() const;
+
+Q_SIGNALS:
+    /** @param status is the SANE_Status of the page. */
+    void pageDone(int status);
+
+private Q_SLOTS:
+    void readerDone();
+    void checkProgress();
+    void hostFinished();
+
+private:
+    bool request(const QStringList &fields, QStringList *replyFields = nullptr);
+    void stopHost(const QString &reason);
+
+    QProcess             *m_host;
+    QSharedMemory         m_ring;
+    QSystemSemaphore     *m_dataSem;
+    QSystemSemaphore     *m_spaceSem;
+    KSaneScanRingReader  *m_reader;
+    KSanePipeline        *m_pipeline;
+    QTimer                m_progressTmr;
+    QElapsedTimer         m_lastProgress;
+    qint64                m_lastBytesRead;
+    int                   m_timeout;
+    bool                  m_scanning;
+    bool                  m_stalled;
+    QString               m_errorString;
+};
+
+}  // NameSpace KSaneIface
+
+#endif
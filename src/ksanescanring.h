@@ -0,0 +1,108 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#ifndef KSANE_SCAN_RING_H
+#define KSANE_SCAN_RING_H
+
+#include <QAtomicInteger>
+#include <QAtomicInt>
+#include <QString>
+
+namespace KSaneIface
+{
+
+/**
+ * The shared memory ring buffer that the scan host process writes the scanned data to.
+ *
+ * The ring starts with a RingHeader. The data area is a stream of records that start at
+ * an 8 byte boundary with a RecordHeader. The payload of a record is never split at the
+ * end of the ring; the writer fills the rest with a RECORD_PAD record instead. The read
+ * and write positions count the bytes since the start, so the ring is empty when they
+ * are equal.
+ *
+ * A reader that finds the ring empty and a writer that finds it full set their waiting
+ * flag and block on a system semaphore. The other side releases the semaphore when it
+ * finds the flag set after moving its position.
+ */
+namespace ScanRing
+{
+static const int HEADER_SIZE  = 64;
+static const int DEFAULT_SIZE = 8 * 1024 * 1024;
+
+enum RecordType {
+    RECORD_PAD,
+    RECORD_PAGE,    ///< PageInfo of the page that follows
+    RECORD_DATA,    ///< scanned bytes
+    RECORD_END      ///< qint32 SANE_Status of the page
+};
+
+struct RingHeader {
+    QAtomicInteger<quint64> writePos;
+    QAtomicInteger<quint64> readPos;
+    QAtomicInt              cancel;
+    QAtomicInt              readerWaiting;
+    QAtomicInt              writerWaiting;
+    quint32                 dataSize;
+};
+
+struct RecordHeader {
+    quint32 type;
+    quint32 length;
+};
+
+struct PageInfo {
+    qint32 format;
+    qint32 pixelsPerLine;
+    qint32 bytesPerLine;
+    qint32 lines;
+    qint32 depth;
+};
+
+inline quint64 recordSize(quint32 length)
+{
+    return (sizeof(RecordHeader) + length + 7) & ~quint64(7);
+}
+
+inline char *dataArea(void *ring)
+{
+    return static_cast<char *>(ring) + HEADER_SIZE;
+}
+
+/** @return the key of the semaphore that wakes the reader of the ring with ringKey. */
+inline QString dataSemaphoreKey(const QString &ringKey)
+{
+    return ringKey + QStringLiteral("-data");
+}
+
+/** @return the key of the semaphore that wakes the writer of the ring with ringKey. */
+inline QString spaceSemaphoreKey(const QString &ringKey)
+{
+    return ringKey + QStringLiteral("-space");
+}
+}
+
+}  // NameSpace KSaneIface
+
+#endif
@@ -0,0 +1,269 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#include "ksanescansession.h"
+
+#include "ksanescanthread.h"
+
+
+namespace KSaneIface
+{
+
+KSaneScanSession::KSaneScanSession(KSanePipeline *pipeline, QObject *parent)
+    : QObject(parent),
+      m_pipeline(pipeline),
+      m_thread(nullptr),
+      m_gammaStage(nullptr),
+      m_stallTimeout(0),
+      m_stallEscalation(10000),
+      m_handleAbandoned(false),
+      m_pipelineWait(false)
+{
+    connect(m_pipeline, SIGNAL(ready()), this, SLOT(pipelineReady()));
+}
+
+KSaneScanSession::~KSaneScanSession()
+{
+    clear();
+}
+
+void KSaneScanSession::createThread(SANE_Handle handle, QByteArray *data)
+{
+    clear();
+    m_thread = new KSaneScanThread(handle, data);
+    m_thread->setStallTimeout(m_stallTimeout, m_stallEscalation);
+    m_thread->setPipeline(m_pipeline);
+    m_thread->setGammaStage(m_gammaStage);
+    connect(m_thread, SIGNAL(finished()), this, SIGNAL(pageDone()));
+    connect(m_thread, SIGNAL(scanAbandoned()), this, SLOT(threadAbandoned()));
+}
+
+void KSaneScanSession::clear()
+{
+    delete m_thread;
+    m_thread = nullptr;
+    m_handleAbandoned = false;
+    m_pipelineWait = false;
+}
+
+KSaneScanThread *KSaneScanSession::thread() const
+{
+    return m_thread;
+}
+
+bool KSaneScanSession::isRunning() const
+{
+    return (m_thread != nullptr) && m_thread->isRunning();
+}
+
+bool KSaneScanSession::handleAbandoned() const
+{
+    return m_handleAbandoned;
+}
+
+void KSaneScanSession::setStallTimeout(int stallMsec, int escalationMsec)
+{
+    m_stallTimeout = qMax(0, stallMsec);
+    m_stallEscalation = qMax(0, escalationMsec);
+    if (m_thread) {
+        m_thread->setStallTimeout(m_stallTimeout, m_stallEscalation);
+    }
+}
+
+void KSaneScanSession::setGammaStage(KSaneRowStage *stage)
+{
+    m_gammaStage = stage;
+    if (m_thread) {
+        m_thread->setGammaStage(m_gammaStage);
+    }
+}
+
+void KSaneScanSession::requestNextPage()
+{
+    if (m_pipeline->isFull()) {
+        // pipelineReady() continues the batch
+        m_pipelineWait = true;
+        return;
+    }
+    emit nextPage();
+}
+
+bool KSaneScanSession::pipelineWait() const
+{
+    return m_pipelineWait;
+}
+
+bool KSaneScanSession::cancelPipelineWait()
+{
+    const bool wait = m_pipelineWait;
+    m_pipelineWait = false;
+    return wait;
+}
+
+void KSaneScanSession::pipelineReady()
+{
+    if (!m_pipelineWait) {
+        return;
+    }
+    m_pipelineWait = false;
+    emit nextPage();
+}
+
+void KSaneScanSession::releaseThread()
+{
+    // the thread is deleted if the backend ever returns
+    KSaneScanThread *thread = m_thread;
+    disconnect(thread, nullptr, this, nullptr);
+    connect(thread, SIGNAL(finished()), thread, SLOT(deleteLater()));
+    if (thread->isFinished()) {
+        thread->deleteLater();
+    }
+
+    // the handle is still used by the blocked backend, so no new scan thread is
+    // created for it and it is not closed
+    m_thread = nullptr;
+    m_handleAbandoned = true;
+}
+
+void KSaneScanSession::threadAbandoned()
+{
+    if (!isRunning()) {
+        // the thread returned after all and pageDone() reports the stall
+        return;
+    }
+    releaseThread();
+    emit abandoned();
+}
+
+bool KSaneScanSession::isBatchScan(const QString &source, const QString &waitForButton)
+{
+    if (source.contains(QStringLiteral("Automatic Document Feeder")) ||
+            source.contains(QStringLiteral("ADF"))) {
+        return true;
+    }
+    // (Note: No translation)
+    return waitForButton == QStringLiteral("true");
+}
+
+KSanePage KSaneScanSession::pageFromParameters(const SANE_Parameters &params, int dataSize)
+{
+    KSanePage page;
+    page.width  = params.pixels_per_line;
+    page.height = params.lines;
+    page.bytesPerLine = bytesPerLine(params);
+    page.format = imageFormat(params);
+    if (page.height == -1) {
+        // this is probably a handscanner -> calculate the size from the read data
+        int bpl = qMax(page.bytesPerLine, 1); // ensure no div by 0
+        page.height = dataSize / bpl;
+    }
+    return page;
+}
+
+KSaneCore::ImageFormat KSaneScanSession::imageFormat(const SANE_Parameters &params)
+{
+    switch (params.format) {
+    case SANE_FRAME_GRAY:
+        switch (params.depth) {
+        case 1:
+            return KSaneCore::FormatBlackWhite;
+        case 8:
+            return KSaneCore::FormatGrayScale8;
+        case 16:
+            return KSaneCore::FormatGrayScale16;
+        default:
+            return KSaneCore::FormatNone;
+        }
+    case SANE_FRAME_RGB:
+    case SANE_FRAME_RED:
+    case SANE_FRAME_GREEN:
+    case SANE_FRAME_BLUE:
+        switch (params.depth) {
+        case 8:
+            return KSaneCore::FormatRGB_8_C;
+        case 16:
+            return KSaneCore::FormatRGB_16_C;
+        default:
+            return KSaneCore::FormatNone;
+        }
+    }
+    return KSaneCore::FormatNone;
+}
+
+int KSaneScanSession::bytesPerLine(const SANE_Parameters &params)
+{
+    switch (imageFormat(params)) {
+    case KSaneCore::FormatBlackWhite:
+    case KSaneCore::FormatGrayScale8:
+    case KSaneCore::FormatGrayScale16:
+        return params.bytes_per_line;
+
+    case KSaneCore::FormatRGB_8_C:
+        return params.pixels_per_line * 3;
+
+    case KSaneCore::FormatRGB_16_C:
+        return params.pixels_per_line * 6;
+
+    case KSaneCore::FormatNone:
+    case KSaneCore::FormatBMP:
+        return 0;
+    }
+    return 0;
+}
+
+KSaneCore::ScanStatus KSaneScanSession::scanStatus(SANE_Status status, QString &message)
+{
+    switch (status) {
+    case SANE_STATUS_NO_DOCS:
+        message = QString::fromLatin1(sane_strstatus(status));
+        return KSaneCore::Information;
+    case SANE_STATUS_UNSUPPORTED:
+    case SANE_STATUS_IO_ERROR:
+    case SANE_STATUS_NO_MEM:
+    case SANE_STATUS_INVAL:
+    case SANE_STATUS_JAMMED:
+    case SANE_STATUS_COVER_OPEN:
+    case SANE_STATUS_DEVICE_BUSY:
+    case SANE_STATUS_ACCESS_DENIED:
+        message = QString::fromLatin1(sane_strstatus(status));
+        return KSaneCore::ErrorGeneral;
+    default:
+        // cancelled or the end of a batch
+        message.clear();
+        return KSaneCore::NoError;
+    }
+}
+
+QString KSaneScanSession::stalledMessage()
+{
+    return QStringLiteral("The scanner stopped sending data and the scan was cancelled.");
+}
+
+QString KSaneScanSession::abandonedMessage()
+{
+    return QStringLiteral("The scanner stopped sending data and does not respond. Please close the device and check the scanner.");
+}
+
+}  // NameSpace KSaneIface
@@ -0,0 +1,140 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#ifndef KSANE_SCAN_SESSION_H
+#define KSANE_SCAN_SESSION_H
+
+#include "ksanecore_export.h"
+#include "ksanecore.h"
+#include "ksanepipeline.h"
+
+// Sane includes
+extern "C"
+{
+#include <sane/saneopts.h>
+#include <sane/sane.h>
+}
+
+#include <QObject>
+#include <QByteArray>
+#include <QString>
+
+namespace KSaneIface
+{
+class KSaneScanThread;
+class KSaneRowStage;
+
+/**
+ * This class keeps the scan thread of an open handle for KSaneCore and KSaneWidget.
+ * It holds the next page of a batch scan back while the pipeline is full and gives up
+ * the thread and its handle when the watchdog abandons the scan.
+ */
+class KSANECORE_EXPORT KSaneScanSession : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit KSaneScanSession(KSanePipeline *pipeline, QObject *parent = nullptr);
+    ~KSaneScanSession();
+
+    /** Create the scan thread of a newly opened handle.
+     * @param data is filled with the data of the page. */
+    void createThread(SANE_Handle handle, QByteArray *data);
+
+    /** Delete the scan thread when the handle is closed. An abandoned thread deletes itself
+     * if the backend ever returns. */
+    void clear();
+
+    /** @return the scan thread or nullptr if there is no handle or the thread was abandoned. */
+    KSaneScanThread *thread() const;
+
+    bool isRunning() const;
+
+    /** @return true if the thread was abandoned. The backend still uses the handle, so the
+     * handle can not be used or closed any more. */
+    bool handleAbandoned() const;
+
+    void setStallTimeout(int stallMsec, int escalationMsec);
+
+    /** Apply the stage to the rows before the stages of the pipeline. */
+    void setGammaStage(KSaneRowStage *stage);
+
+    /** Emit nextPage() for the next page of a batch when the pipeline can take it. */
+    void requestNextPage();
+
+    /** @return true if the next page waits for the pipeline. */
+    bool pipelineWait() const;
+
+    /** Do not start the page that waits for the pipeline.
+     * @return true if a page was waiting. */
+    bool cancelPipelineWait();
+
+    /** Give up the thread of an abandoned scan and its handle. */
+    void releaseThread();
+
+    /** @return true if the source or the wait-for-button value start a batch scan. */
+    static bool isBatchScan(const QString &source, const QString &waitForButton);
+
+    /** @return the page of the read data without the pixel data. */
+    static KSanePage pageFromParameters(const SANE_Parameters &params, int dataSize);
+
+    static KSaneCore::ImageFormat imageFormat(const SANE_Parameters &params);
+    static int bytesPerLine(const SANE_Parameters &params);
+
+    /** @return the KSaneCore::ScanStatus of a scan that ended with status.
+     * @param message is set to the untranslated SANE message. */
+    static KSaneCore::ScanStatus scanStatus(SANE_Status status, QString &message);
+
+    /** The untranslated messages of KSaneCore. The widget translates its own. */
+    static QString stalledMessage();
+    static QString abandonedMessage();
+
+Q_SIGNALS:
+    /** The thread has read a page or the scan failed. */
+    void pageDone();
+
+    /** The next page of a batch can be started. */
+    void nextPage();
+
+    /** The scan was abandoned and the thread is released. */
+    void abandoned();
+
+private Q_SLOTS:
+    void threadAbandoned();
+    void pipelineReady();
+
+private:
+    KSanePipeline   *m_pipeline;
+    KSaneScanThread *m_thread;
+    KSaneRowStage   *m_gammaStage;
+    int              m_stallTimeout;
+    int              m_stallEscalation;
+    bool             m_handleAbandoned;
+    bool             m_pipelineWait;
+};
+
+}  // NameSpace KSaneIface
+
+#endif // KSANE_SCAN_SESSION_H
@@ -27,9 +27,15 @@
 * ============================================================ */
 
 #include "ksanescanthread.h"
+#include "ksanescanwatchdog.h"
+#include "ksanepipeline.h"
+#include "ksanescansession.h"
 
 #include <QDebug>
 
+#include <math.h>
+#include <string.h>
+
 namespace KSaneIface
 {
 
@@ -44,8 +50,73 @@ KSaneScanThread::KSaneScanThread(SANE_Handle handle, QByteArray *data):
     m_saneStatus(SANE_STATUS_GOOD),
     m_readStatus(READ_READY),
     m_saneStartDone(false),
-    m_invertColors(false)
-{}
+    m_invertColors(false),
+    m_streamRegions(false),
+    m_lineFill(0),
+    m_lineIndex(0),
+    m_pipeline(nullptr),
+    m_gammaStage(nullptr),
+    m_rowsFed(0),
+    m_startLatency(-1)
+{
+    m_watchdog = new KSaneScanWatchdog(this, handle);
+}
+
+KSaneScanThread::~KSaneScanThread()
+{
+    delete m_watchdog;
+}
+
+void KSaneScanThread::setStallTimeout(int stallMsec, int escalationMsec)
+{
+    m_watchdog->setTimeouts(stallMsec, escalationMsec);
+}
+
+qint64 KSaneScanThread::bytesRead()
+{
+    return m_bytesRead.loadAcquire();
+}
+
+bool KSaneScanThread::stalled()
+{
+    return m_stalled.loadAcquire() != 0;
+}
+
+bool KSaneScanThread::abandoned()
+{
+    return m_abandoned.loadAcquire() != 0;
+}
+
+void KSaneScanThread::markStalled()
+{
+    m_stalled.storeRelease(1);
+}
+
+void KSaneScanThread::abandon()
+{
+    m_abandoned.storeRelease(1);
+    emit scanAbandoned();
+}
+
+void KSaneScanThread::setPipeline(KSanePipeline *pipeline)
+{
+    m_pipeline = pipeline;
+}
+
+void KSaneScanThread::setGammaStage(KSaneRowStage *stage)
+{
+    m_gammaStage = stage;
+}
+
+void KSaneScanThread::setRequestTimer(const QElapsedTimer &timer)
+{
+    m_requestTimer = timer;
+}
+
+qint64 KSaneScanThread::startLatency()
+{
+    return m_startLatency;
+}
 
 void KSaneScanThread::setImageInverted(bool inverted)
 {
@@ -73,6 +144,13 @@ SANE_Parameters KSaneScanThread::saneParameters()
 }
 
 void KSaneScanThread::run()
+{
+    m_stalled.storeRelease(0);
+    scan();
+    m_watchdog->disarm();
+}
+
+void KSaneScanThread::scan()
 {
     m_dataSize = 0;
     m_readStatus = READ_ON_GOING;
@@ -81,6 +159,12 @@ void KSaneScanThread::run()
     // Start the scanning with sane_start
     m_saneStatus = sane_start(m_saneHandle);
 
+    if (m_requestTimer.isValid()) {
+        m_startLatency = m_requestTimer.elapsed();
+        m_requestTimer.invalidate();
+    } else {
+        m_startLatency = -1;
+    }
     m_saneStartDone = true;
 
     if (m_readStatus == READ_CANCEL) {
@@ -114,16 +198,32 @@ void KSaneScanThread::run()
     }
 
     m_data->clear();
-    if (m_dataSize > 0) {
+    prepareRegions(m_params.lines);
+    if ((m_dataSize > 0) && !m_streamRegions) {
         m_data->reserve(m_dataSize);
     }
+    beginRows();
 
     m_frameRead     = 0;
     m_frame_t_count = 0;
     m_readStatus    = READ_ON_GOING;
+    m_watchdog->arm();
     while (m_readStatus == READ_ON_GOING) {
         readData();
     }
+
+    if ((m_readStatus == READ_READY) && (m_pipeline || m_gammaStage) &&
+            (m_params.format != SANE_FRAME_GRAY) && (m_params.format != SANE_FRAME_RGB)) {
+        // the rows of a three-pass scan are complete after the last frame
+        int bytesPerLine = m_params.bytes_per_line * 3;
+        if (bytesPerLine > 0) {
+            processRows(m_data->data(), 0, m_data->size() / bytesPerLine, bytesPerLine);
+        }
+    }
+
+    if ((m_readStatus == READ_READY) && !m_regions.isEmpty()) {
+        finishRegions();
+    }
 }
 
 int KSaneScanThread::scanProgress()
@@ -147,6 +247,15 @@ void KSaneScanThread::readData()
     SANE_Int readBytes = 0;
     m_saneStatus = sane_read(m_saneHandle, m_readData, SCAN_READ_CHUNK_SIZE, &readBytes);
 
+    if (m_abandoned.loadAcquire()) {
+        // the owner may not exist any more
+        m_readStatus = READ_ERROR;
+        return;
+    }
+    if (readBytes > 0) {
+        m_bytesRead.fetchAndAddRelease(readBytes);
+    }
+
     switch (m_saneStatus) {
     case SANE_STATUS_GOOD:
         // continue to parsing the data
@@ -232,14 +341,24 @@ void KSaneScanThread::copyToScanData(int readBytes)
     }
     switch (m_params.format) {
     case SANE_FRAME_GRAY:
-        m_data->append((const char *)m_readData, readBytes);
+        if (m_streamRegions) {
+            streamToRegions(readBytes);
+        } else {
+            m_data->append((const char *)m_readData, readBytes);
+            feedRows();
+        }
         m_frameRead += readBytes;
         return;
     case SANE_FRAME_RGB:
         if (m_params.depth == 1) {
             break;
         }
-        m_data->append((const char *)m_readData, readBytes);
+        if (m_streamRegions) {
+            streamToRegions(readBytes);
+        } else {
+            m_data->append((const char *)m_readData, readBytes);
+            feedRows();
+        }
         m_frameRead += readBytes;
         return;
 
@@ -299,9 +418,239 @@ void KSaneScanThread::copyToScanData(int readBytes)
     return;
 }
 
+void KSaneScanThread::beginRows()
+{
+    m_rowsFed = 0;
+    if (!m_pipeline && !m_gammaStage) {
+        return;
+    }
+
+    KSanePage page;
+    page.width  = m_params.pixels_per_line;
+    page.height = m_params.lines;
+    page.bytesPerLine = m_params.bytes_per_line;
+    if ((m_params.format != SANE_FRAME_GRAY) && (m_params.format != SANE_FRAME_RGB)) {
+        // the three pass frames are combined to one RGB image
+        page.bytesPerLine *= 3;
+    }
+    page.format = KSaneScanSession::imageFormat(m_params);
+    if (m_gammaStage) {
+        m_gammaStage->beginPage(page);
+    }
+    if (m_pipeline) {
+        m_pipeline->beginRows(page);
+    }
+}
+
+void KSaneScanThread::feedRows()
+{
+    int bytesPerLine = m_params.bytes_per_line;
+    if ((!m_pipeline && !m_gammaStage) || (bytesPerLine <= 0)) {
+        return;
+    }
+
+    // only complete rows are passed, the rest follows with the next read
+    int rows = m_data->size() / bytesPerLine;
+    if (rows > m_rowsFed) {
+        processRows(m_data->data() + (m_rowsFed * bytesPerLine), m_rowsFed,
+                    rows - m_rowsFed, bytesPerLine);
+        m_rowsFed = rows;
+    }
+}
+
+void KSaneScanThread::processRows(char *rows, int firstRow, int rowCount, int bytesPerLine)
+{
+    // the gamma changes the data the other stages see
+    if (m_gammaStage) {
+        m_gammaStage->processRows(rows, firstRow, rowCount, bytesPerLine);
+    }
+    if (m_pipeline) {
+        m_pipeline->processRows(rows, firstRow, rowCount, bytesPerLine);
+    }
+}
+
 bool KSaneScanThread::saneStartDone()
 {
     return   m_saneStartDone;
 }
 
+void KSaneScanThread::setCropRegions(const QList<QRectF> &regions)
+{
+    m_regions.clear();
+    for (int i = 0; i < regions.size(); i++) {
+        CropRegion region;
+        region.area = regions.at(i).normalized() & QRectF(0, 0, 1, 1);
+        region.byteStart = 0;
+        region.byteCount = 0;
+        m_regions.append(region);
+    }
+}
+
+int KSaneScanThread::cropRegionCount()
+{
+    return m_regions.size();
+}
+
+QByteArray &KSaneScanThread::regionData(int index)
+{
+    return m_regions[index].data;
+}
+
+QRect KSaneScanThread::regionRect(int index)
+{
+    return m_regions.at(index).pixels;
+}
+
+int KSaneScanThread::regionBytesPerLine(int index)
+{
+    return m_regions.at(index).byteCount;
+}
+
+void KSaneScanThread::prepareRegions(int lines)
+{
+    m_streamRegions = false;
+    if (m_regions.isEmpty()) {
+        return;
+    }
+
+    int pixels = m_params.pixels_per_line;
+    int bytesPerPixel = m_params.depth / 8;
+    if (m_params.format != SANE_FRAME_GRAY) {
+        // the three pass frames are combined to one RGB image
+        bytesPerPixel *= 3;
+    }
+
+    for (int i = 0; i < m_regions.size(); i++) {
+        CropRegion &region = m_regions[i];
+        int x1 = qBound(0, (int)floor(region.area.left() * pixels), pixels);
+        int x2 = qBound(0, (int)ceil(region.area.right() * pixels), pixels);
+        int y1 = 0;
+        int y2 = 0;
+        if (lines > 0) {
+            y1 = qBound(0, (int)floor(region.area.top() * lines), lines);
+            y2 = qBound(0, (int)ceil(region.area.bottom() * lines), lines);
+        }
+        if (m_params.depth == 1) {
+            // the rows of a region that does not start at a byte boundary are shifted
+            region.byteStart = x1 / 8;
+            region.byteCount = (x2 - x1 + 7) / 8;
+            region.bitShift  = x1 % 8;
+        } else {
+            region.byteStart = x1 * bytesPerPixel;
+            region.byteCount = (x2 - x1) * bytesPerPixel;
+            region.bitShift  = 0;
+        }
+        region.pixels = QRect(x1, y1, x2 - x1, y2 - y1);
+        region.data.clear();
+        if (lines > 0) {
+            region.data.reserve(region.byteCount * (y2 - y1));
+        }
+    }
+
+    // The rows can be cropped while reading if the line count is known and the
+    // frame contains the whole image. The line-art bytes_per_line workaround is
+    // done at the end of the scan, so that needs the whole image too.
+    m_streamRegions = (lines > 0) &&
+                      (m_params.depth >= 8) &&
+                      ((m_params.format == SANE_FRAME_GRAY) || (m_params.format == SANE_FRAME_RGB));
+    if (m_streamRegions) {
+        m_lineBuffer.resize(m_params.bytes_per_line);
+        m_lineFill = 0;
+        m_lineIndex = 0;
+    }
+}
+
+void KSaneScanThread::cropLine(const char *line, int row)
+{
+    for (int i = 0; i < m_regions.size(); i++) {
+        CropRegion &region = m_regions[i];
+        if ((row < region.pixels.top()) || (row > region.pixels.bottom())) {
+            continue;
+        }
+        if (region.bitShift == 0) {
+            region.data.append(line + region.byteStart, region.byteCount);
+            continue;
+        }
+
+        // Line-art: move the first pixel of the region to the top bit and clear
+        // the bits after the last pixel.
+        const uchar *src = (const uchar *)line + region.byteStart;
+        int srcBytes = m_params.bytes_per_line - region.byteStart;
+        int oldSize = region.data.size();
+        region.data.resize(oldSize + region.byteCount);
+        uchar *dst = (uchar *)region.data.data() + oldSize;
+        for (int j = 0; j < region.byteCount; j++) {
+            uchar next = (j + 1 < srcBytes) ? src[j + 1] : 0;
+            dst[j] = (uchar)((src[j] << region.bitShift) | (next >> (8 - region.bitShift)));
+        }
+        int tailBits = region.pixels.width() % 8;
+        if (tailBits != 0) {
+            dst[region.byteCount - 1] &= (uchar)(0xFF << (8 - tailBits));
+        }
+    }
+}
+
+void KSaneScanThread::streamToRegions(int readBytes)
+{
+    char *src = (char *)m_readData;
+    int lineBytes = m_lineBuffer.size();
+
+    while (readBytes > 0) {
+        if ((m_lineFill == 0) && (readBytes >= lineBytes)) {
+            // whole lines can be processed and cropped directly from the read buffer
+            int rows = readBytes / lineBytes;
+            processRows(src, m_lineIndex, rows, lineBytes);
+            for (int i = 0; i < rows; i++) {
+                cropLine(src, m_lineIndex);
+                m_lineIndex++;
+                src += lineBytes;
+            }
+            readBytes -= rows * lineBytes;
+            continue;
+        }
+        int count = qMin(lineBytes - m_lineFill, readBytes);
+        memcpy(m_lineBuffer.data() + m_lineFill, src, count);
+        m_lineFill += count;
+        src += count;
+        readBytes -= count;
+        if (m_lineFill == lineBytes) {
+            processRows(m_lineBuffer.data(), m_lineIndex, 1, lineBytes);
+            cropLine(m_lineBuffer.constData(), m_lineIndex);
+            m_lineIndex++;
+            m_lineFill = 0;
+        }
+    }
+}
+
+void KSaneScanThread::finishRegions()
+{
+    if (!m_streamRegions) {
+        // crop the regions from the whole image
+        int bytesPerLine = m_params.bytes_per_line;
+        if ((m_params.format != SANE_FRAME_GRAY) && (m_params.format != SANE_FRAME_RGB)) {
+            bytesPerLine *= 3;
+        }
+        if (bytesPerLine <= 0) {
+            return;
+        }
+        int lines = m_data->size() / bytesPerLine;
+        if (m_params.lines <= 0) {
+            // hand scanners do not know the line count in advance
+            prepareRegions(lines);
+        }
+        for (int row = 0; row < lines; row++) {
+            cropLine(m_data->constData() + (row * bytesPerLine), row);
+        }
+        m_data->clear();
+    }
+
+    // a scan can end before all the lines are read
+    for (int i = 0; i < m_regions.size(); i++) {
+        CropRegion &region = m_regions[i];
+        if (region.byteCount > 0) {
+            region.pixels.setHeight(region.data.size() / region.byteCount);
+        }
+    }
+}
+
 }  // NameSpace KSaneIface
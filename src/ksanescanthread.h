@@ -29,6 +29,8 @@
 #ifndef KSANE_SCAN_THREAD_H
 #define KSANE_SCAN_THREAD_H
 
+#include "ksanecore_export.h"
+
 // Sane includes
 extern "C"
 {
@@ -38,14 +40,24 @@ extern "C"
 
 #include <QThread>
 #include <QByteArray>
+#include <QVector>
+#include <QRectF>
+#include <QRect>
+#include <QElapsedTimer>
+#include <QAtomicInt>
 
 #define SCAN_READ_CHUNK_SIZE 100000
 
 namespace KSaneIface
 {
-class KSaneScanThread: public QThread
+class KSaneScanWatchdog;
+class KSanePipeline;
+class KSaneRowStage;
+
+class KSANECORE_EXPORT KSaneScanThread: public QThread
 {
     Q_OBJECT
+    friend class KSaneScanWatchdog;
 public:
     typedef enum {
         READ_ON_GOING,
@@ -55,6 +67,7 @@ public:
     } ReadStatus;
 
     KSaneScanThread(SANE_Handle handle, QByteArray *data);
+    ~KSaneScanThread();
     void run() override;
     void setImageInverted(bool);
     void cancelScan();
@@ -65,9 +78,75 @@ public:
     SANE_Status saneStatus();
     SANE_Parameters saneParameters();
 
+    /** Crop regions out of the scanned image instead of returning the whole image.
+     * When possible the regions are cropped from the rows as they are read,
+     * so that the whole image is never stored in memory.
+     * \param regions are relative to the scanned area (0.0 -> 1.0).
+     * An empty list disables cropping. */
+    void setCropRegions(const QList<QRectF> &regions);
+    int cropRegionCount();
+    /** \return the cropped data of a region. Only valid after a successful scan. */
+    QByteArray &regionData(int index);
+    /** \return the geometry of a region in pixels of the scanned image. */
+    QRect regionRect(int index);
+    int regionBytesPerLine(int index);
+
+    /** Measure the time from the start of timer to the return of the next sane_start().
+     * This must be called before start(). */
+    void setRequestTimer(const QElapsedTimer &timer);
+    /** \return the milliseconds measured with the request timer or -1 if the
+     * last scan was started without one. Only valid when saneStartDone() is true. */
+    qint64 startLatency();
+
+    /** Cancel the scan when no data is read for stallMsec. See KSaneScanWatchdog.
+     * \param stallMsec is the stall timeout or 0 to disable the watchdog (default).
+     * \param escalationMsec is the time between the cancel steps. */
+    void setStallTimeout(int stallMsec, int escalationMsec);
+    /** \return the number of bytes read since the thread was created. */
+    qint64 bytesRead();
+    /** \return true if the last scan was cancelled by the watchdog. */
+    bool stalled();
+    /** \return true if the watchdog gave up the thread. The thread may still be blocked
+     * in the backend, but it does not touch the owner any more. */
+    bool abandoned();
+
+    /** Pass the rows of every page to the row stages of pipeline while they are read.
+     * This must be called before start(). nullptr disables the row stages. */
+    void setPipeline(KSanePipeline *pipeline);
+
+    /** Run stage on the rows before the stages of the pipeline. This is used for the
+     * software gamma of KSaneWidget. It must be called before start(). */
+    void setGammaStage(KSaneRowStage *stage);
+
+Q_SIGNALS:
+    /** This signal is emitted in the watchdog thread when the scan thread is blocked
+     * in the backend and does not react to sane_cancel(). The data it reads after this
+     * signal is dropped, so the owner can give up the thread and its handle. */
+    void scanAbandoned();
+
 private:
+    void scan();
+    void markStalled();
+    void abandon();
+
+    struct CropRegion {
+        QRectF     area;
+        QRect      pixels;
+        int        byteStart;
+        int        byteCount;
+        int        bitShift;    ///< the line-art pixel offset of the region in the first byte
+        QByteArray data;
+    };
+
     void readData();
     void copyToScanData(int readBytes);
+    void beginRows();
+    void feedRows();
+    void processRows(char *rows, int firstRow, int rowCount, int bytesPerLine);
+    void prepareRegions(int lines);
+    void cropLine(const char *line, int row);
+    void streamToRegions(int readBytes);
+    void finishRegions();
 
     SANE_Byte       m_readData[SCAN_READ_CHUNK_SIZE];
     QByteArray     *m_data;
@@ -81,6 +160,24 @@ private:
     ReadStatus      m_readStatus;
     bool            m_saneStartDone;
     bool            m_invertColors;
+
+    QVector<CropRegion> m_regions;
+    bool            m_streamRegions;
+    QByteArray      m_lineBuffer;
+    int             m_lineFill;
+    int             m_lineIndex;
+
+    KSanePipeline  *m_pipeline;
+    KSaneRowStage  *m_gammaStage;
+    int             m_rowsFed;
+
+    QElapsedTimer   m_requestTimer;
+    qint64          m_startLatency;
+
+    KSaneScanWatchdog      *m_watchdog;
+    QAtomicInteger<qint64>  m_bytesRead;
+    QAtomicInt              m_stalled;
+    QAtomicInt              m_abandoned;
 };
 }
 
@@ -0,0 +1,148 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#include "ksanescanwatchdog.h"
+
+#include "ksanescanthread.h"
+
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include <QDebug>
+
+static const int WATCHDOG_CHECK_INTERVAL = 250;
+
+namespace KSaneIface
+{
+
+KSaneScanWatchdog::KSaneScanWatchdog(KSaneScanThread *scanThread, SANE_Handle handle)
+    : QThread(),
+      m_scanThread(scanThread),
+      m_handle(handle),
+      m_stallTimeout(0),
+      m_escalationTimeout(0),
+      m_armed(false),
+      m_stop(false)
+{}
+
+KSaneScanWatchdog::~KSaneScanWatchdog()
+{
+    stop();
+}
+
+void KSaneScanWatchdog::stop()
+{
+    QMutexLocker locker(&m_mutex);
+    m_stop = true;
+    m_wake.wakeAll();
+    locker.unlock();
+    wait();
+}
+
+void KSaneScanWatchdog::setTimeouts(int stallMsec, int escalationMsec)
+{
+    QMutexLocker locker(&m_mutex);
+    m_stallTimeout = qMax(0, stallMsec);
+    m_escalationTimeout = qMax(WATCHDOG_CHECK_INTERVAL, escalationMsec);
+    m_wake.wakeAll();
+    locker.unlock();
+
+    // the thread sleeps while it is not armed
+    if ((m_stallTimeout > 0) && !isRunning()) {
+        start();
+    }
+}
+
+void KSaneScanWatchdog::arm()
+{
+    QMutexLocker locker(&m_mutex);
+    m_armed = true;
+    m_wake.wakeAll();
+}
+
+void KSaneScanWatchdog::disarm()
+{
+    QMutexLocker locker(&m_mutex);
+    m_armed = false;
+    m_wake.wakeAll();
+}
+
+void KSaneScanWatchdog::run()
+{
+    QMutexLocker locker(&m_mutex);
+    while (!m_stop) {
+        if (!m_armed || (m_stallTimeout == 0)) {
+            m_wake.wait(&m_mutex);
+            continue;
+        }
+
+        qint64 lastBytes = m_scanThread->bytesRead();
+        Stage stage = STAGE_WATCH;
+        QElapsedTimer idle;
+        idle.start();
+
+        while (m_armed && !m_stop) {
+            m_wake.wait(&m_mutex, WATCHDOG_CHECK_INTERVAL);
+            if (!m_armed || m_stop) {
+                break;
+            }
+
+            const qint64 bytes = m_scanThread->bytesRead();
+            if (bytes != lastBytes) {
+                lastBytes = bytes;
+                idle.start();
+                continue;
+            }
+            if (idle.elapsed() < ((stage == STAGE_WATCH) ? m_stallTimeout : m_escalationTimeout)) {
+                continue;
+            }
+            idle.start();
+
+            switch (stage) {
+            case STAGE_WATCH:
+                qDebug() << "No scan data for" << m_stallTimeout << "ms, cancelling the scan";
+                m_scanThread->markStalled();
+                m_scanThread->cancelScan();
+                stage = STAGE_SOFT_CANCEL;
+                break;
+            case STAGE_SOFT_CANCEL:
+                qDebug() << "The scan did not stop, calling sane_cancel()";
+                locker.unlock();
+                sane_cancel(m_handle);
+                locker.relock();
+                stage = STAGE_SANE_CANCEL;
+                break;
+            case STAGE_SANE_CANCEL:
+                qDebug() << "The backend does not return, abandoning the scan";
+                m_armed = false;
+                locker.unlock();
+                m_scanThread->abandon();
+                locker.relock();
+                break;
+            }
+        }
+    }
+}
+
+}  // NameSpace KSaneIface
@@ -0,0 +1,95 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#ifndef KSANE_SCAN_WATCHDOG_H
+#define KSANE_SCAN_WATCHDOG_H
+
+// Sane includes
+extern "C"
+{
+#include <sane/saneopts.h>
+#include <sane/sane.h>
+}
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+
+namespace KSaneIface
+{
+
+class KSaneScanThread;
+
+/**
+ * This thread watches the data that is read by a KSaneScanThread. When no data is read
+ * for the stall timeout, the scan is cancelled in steps, with the escalation timeout
+ * between the steps:
+ * 1. KSaneScanThread::cancelScan() stops the scan after the running sane_read().
+ * 2. sane_cancel() is called from this thread to interrupt the backend.
+ * 3. The scan thread is abandoned with KSaneScanThread::scanAbandoned().
+ *
+ * sane_start() is not watched, because it waits for the document or the scan button.
+ */
+class KSaneScanWatchdog : public QThread
+{
+    Q_OBJECT
+
+public:
+    KSaneScanWatchdog(KSaneScanThread *scanThread, SANE_Handle handle);
+    ~KSaneScanWatchdog();
+
+    /** @param stallMsec is the time without data before the scan is cancelled. 0 disables the watchdog.
+     * @param escalationMsec is the time between the cancel steps. */
+    void setTimeouts(int stallMsec, int escalationMsec);
+
+    /** Start watching. This is called by the scan thread when the data is read. */
+    void arm();
+    void disarm();
+
+    void stop();
+
+protected:
+    void run() override;
+
+private:
+    enum Stage {
+        STAGE_WATCH,
+        STAGE_SOFT_CANCEL,
+        STAGE_SANE_CANCEL
+    };
+
+    KSaneScanThread *m_scanThread;
+    SANE_Handle      m_handle;
+    QMutex           m_mutex;
+    QWaitCondition   m_wake;
+    int              m_stallTimeout;
+    int              m_escalationTimeout;
+    bool             m_armed;
+    bool             m_stop;
+};
+
+}  // NameSpace KSaneIface
+
+#endif
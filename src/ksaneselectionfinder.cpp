@@ -0,0 +1,592 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Automatic selection detection for preview images
+ *
+ * Copyright (C) 2010 by Kare Sars <kare dot sars at iki dot fi>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#include "ksaneselectionfinder.h"
+
+#include <QtConcurrentRun>
+#include <QtConcurrentMap>
+#include <QThread>
+#include <QVector>
+#include <QRect>
+
+#include <math.h>
+#include <string.h>
+
+namespace KSaneIface
+{
+
+// The change trigger before adding to the sum
+static const int DIFF_TRIGGER = 8;
+
+// The selection start/stop level trigger
+static const int SUM_TRIGGER = 4;
+
+// The selection start/stop level trigger for the floating  average
+static const int AVERAGE_TRIGGER = 7;
+
+// The selection start/stop margin
+static const int SEL_MARGIN = 3;
+
+// Maximum number of allowed selections (this could be a settable variable)
+static const int MAX_NUM_SELECTIONS = 8;
+
+// floating average 'div' must be one less than 'count'
+static const int AVERAGE_COUNT = 50;
+static const int AVERAGE_MULT = 49;
+
+// Minimum selection area compared to the whole image
+static const float MIN_AREA_SIZE = 0.01;
+
+// Minimum number of rows in one band of the parallel gradient calculation
+static const int MIN_BAND_HEIGHT = 16;
+
+// One horizontal band of the reduced image.
+// colPrefix holds, for every row of the band, the column sums of the band
+// from its first row up to and including that row.
+struct GradientBand {
+    int              firstRow;
+    int              lastRow;
+    int              width;
+    const QImage    *img;
+    QVector<qint64>  colPrefix;
+    QVector<qint64>  rowSums;
+};
+
+static QImage rgb32Image(const QImage &img)
+{
+    if ((img.format() == QImage::Format_RGB32) || (img.format() == QImage::Format_ARGB32)) {
+        return img;
+    }
+    return img.convertToFormat(QImage::Format_RGB32);
+}
+
+static inline const QRgb *imgLine(const QImage &img, int row)
+{
+    return reinterpret_cast<const QRgb *>(img.constScanLine(row));
+}
+
+static void calculateBand(GradientBand &band)
+{
+    const int width = band.width;
+    const QImage &img = *band.img;
+    int pix;
+    int diff;
+
+    band.colPrefix.fill(0, (band.lastRow - band.firstRow + 1) * width);
+    band.rowSums.fill(0, band.lastRow - band.firstRow + 1);
+
+    for (int h = band.firstRow; h <= band.lastRow; h++) {
+        const int r = h - band.firstRow;
+        qint64 *sums = band.colPrefix.data() + (r * width);
+        if (r > 0) {
+            memcpy(sums, sums - width, width * sizeof(qint64));
+        }
+        const QRgb *prev = imgLine(img, h - 1);
+        const QRgb *line = imgLine(img, h);
+        const QRgb *next = imgLine(img, h + 1);
+        qint64 rowSum = 0;
+
+        // Special case for the left most pixel
+        pix = qGray(line[0]);
+        diff  = qAbs(pix - qGray(line[1]));
+        diff += qAbs(pix - qGray(prev[0]));
+        diff += qAbs(pix - qGray(next[0]));
+        if (diff > DIFF_TRIGGER) {
+            sums[0] += diff;
+            rowSum += diff;
+        }
+
+        // Special case for the right most pixel
+        pix = qGray(line[width - 1]);
+        diff  = qAbs(pix - qGray(line[width - 2]));
+        diff += qAbs(pix - qGray(prev[width - 1]));
+        diff += qAbs(pix - qGray(next[width - 1]));
+        if (diff > DIFF_TRIGGER) {
+            sums[width - 1] += diff;
+            rowSum += diff;
+        }
+
+        for (int w = 1; w < (width - 1); w++) {
+            pix = qGray(line[w]);
+            diff = 0;
+            // how much does the pixel differ from the surrounding
+            diff += qAbs(pix - qGray(line[w - 1]));
+            diff += qAbs(pix - qGray(line[w + 1]));
+            diff += qAbs(pix - qGray(prev[w]));
+            diff += qAbs(pix - qGray(next[w]));
+            if (diff > DIFF_TRIGGER) {
+                sums[w] += diff;
+                rowSum += diff;
+            }
+        }
+        band.rowSums[r] = rowSum;
+    }
+}
+
+KSaneSelectionFinder::KSaneSelectionFinder(QObject *parent)
+    : QObject(parent), m_active(false)
+{
+    connect(&m_watcher, SIGNAL(finished()), this, SLOT(searchDone()));
+}
+
+KSaneSelectionFinder::~KSaneSelectionFinder()
+{
+    // the search only uses its own copy of the image, but do not leave it running
+    m_watcher.waitForFinished();
+}
+
+void KSaneSelectionFinder::start(const QImage &img, float area)
+{
+    m_active = true;
+    m_watcher.setFuture(QtConcurrent::run(&KSaneSelectionFinder::findSelections, img, area));
+}
+
+void KSaneSelectionFinder::cancel()
+{
+    m_active = false;
+}
+
+bool KSaneSelectionFinder::isRunning() const
+{
+    return m_active && m_watcher.isRunning();
+}
+
+void KSaneSelectionFinder::searchDone()
+{
+    if (!m_active) {
+        return;
+    }
+    m_active = false;
+    emit selectionsFound(m_watcher.result());
+}
+
+QList<QRectF> KSaneSelectionFinder::findSelections(const QImage &img, float area)
+{
+    QList<QRectF> selections;
+    int pixelMargin;
+
+    QImage rgbImg = rgb32Image(img);
+
+    selections = detectSelections(rgbImg, area, pixelMargin);
+    refineSelections(rgbImg, selections, pixelMargin);
+    removeSmallSelections(rgbImg, selections);
+    return selections;
+}
+
+void KSaneSelectionFinder::removeSmallSelections(const QImage &img, QList<QRectF> &selections)
+{
+    // check that the selections are big enough
+    float minArea = img.height() * img.width() * MIN_AREA_SIZE;
+    int i = 0;
+    while (i < selections.size()) {
+        if ((selections[i].width() * selections[i].height()) < minArea) {
+            selections.removeAt(i);
+        } else {
+            i++;
+        }
+    }
+}
+
+QList<QRectF> KSaneSelectionFinder::detectSelections(const QImage &orig, float area, int &pixelMargin)
+{
+    QList<QRectF> selections;
+    pixelMargin = 0;
+
+    if ((orig.width() < 3) || (orig.height() < 3)) {
+        return selections;
+    }
+
+    // Reduce the size of the image to decrease noise and calculation time
+    float multiplier = sqrt(area / (orig.height() * orig.width()));
+
+    int width  = (int)(orig.width() * multiplier);
+    int height = (int)(orig.height() * multiplier);
+
+    QImage img = rgb32Image(orig.scaled(width, height, Qt::KeepAspectRatio));
+    height = img.height(); // the size was probably not exact
+    width  = img.width();
+
+    if ((width < 3) || (height < 3)) {
+        return selections;
+    }
+
+    // 1/multiplier is the error margin caused by the resolution reduction
+    pixelMargin = qRound(1 / multiplier);
+
+    // Calculate the gradients of the rows 1 -> height-2 in parallel bands.
+    // The last row does not contribute to the sums.
+    int numBands = qMax(1, QThread::idealThreadCount());
+    numBands = qMin(numBands, qMax(1, (height - 2) / MIN_BAND_HEIGHT));
+    const int rowsPerBand = (height - 2 + numBands - 1) / numBands;
+
+    QVector<GradientBand> bands;
+    for (int first = 1; first <= height - 2; first += rowsPerBand) {
+        GradientBand band;
+        band.firstRow = first;
+        band.lastRow = qMin(first + rowsPerBand - 1, height - 2);
+        band.width = width;
+        band.img = &img;
+        bands.append(band);
+    }
+    QtConcurrent::blockingMap(bands, calculateBand);
+
+    // Merge the bands: bandOffsets[b] is the sum of all the rows before band b
+    QVector<QVector<qint64> > bandOffsets(bands.size());
+    QVector<qint64> offset(width);
+    offset.fill(0);
+    for (int b = 0; b < bands.size(); b++) {
+        bandOffsets[b] = offset;
+        const qint64 *last = bands[b].colPrefix.constData() + ((bands[b].lastRow - bands[b].firstRow) * width);
+        for (int w = 0; w < width; w++) {
+            offset[w] += last[w];
+        }
+    }
+    // rowBand[h] is the band of row h
+    QVector<int> rowBand(height);
+    rowBand.fill(-1);
+    for (int b = 0; b < bands.size(); b++) {
+        for (int h = bands[b].firstRow; h <= bands[b].lastRow; h++) {
+            rowBand[h] = b;
+        }
+    }
+
+    // colSumsAt(h) returns the sums of the rows 1 -> h
+    QVector<qint64> prefixAt(width);
+    auto colSumsAt = [&](int h, QVector<qint64> &sums) {
+        if (h == height - 1) {
+            h = height - 2;
+        }
+        if ((h < 1) || (rowBand[h] < 0)) {
+            sums.fill(0);
+            return;
+        }
+        const GradientBand &band = bands[rowBand[h]];
+        const qint64 *bandSums = band.colPrefix.constData() + ((h - band.firstRow) * width);
+        const qint64 *bandOffset = bandOffsets[rowBand[h]].constData();
+        for (int w = 0; w < width; w++) {
+            sums[w] = bandSums[w] + bandOffset[w];
+        }
+    };
+
+    QVector<qint64> colSums(width + SEL_MARGIN + 1);
+    colSums.fill(0);
+    qint64 rowSum;
+    int lastReset = 0;
+    int hSelStart = -1;
+    int hSelEnd = -1;
+    int hSelMargin = 0;
+    int wSelStart = -1;
+    int wSelEnd = -1;
+    int wSelMargin = 0;
+
+    for (int h = 1; h < height; h++) {
+        rowSum = 0;
+        if (h < height - 1) {
+            const GradientBand &band = bands[rowBand[h]];
+            rowSum = band.rowSums[h - band.firstRow];
+        }
+
+        if ((rowSum / width) > SUM_TRIGGER) {
+            if (hSelStart < 0) {
+                if (hSelMargin < SEL_MARGIN) {
+                    hSelMargin++;
+                }
+                if (hSelMargin == SEL_MARGIN) {
+                    hSelStart = h - SEL_MARGIN + 1;
+                }
+            }
+        } else {
+            if (hSelStart >= 0) {
+                if (hSelMargin > 0) {
+                    hSelMargin--;
+                }
+            }
+            if ((hSelStart > -1) && ((hSelMargin == 0) || (h == height - 1))) {
+                if (h == height - 1) {
+                    hSelEnd = h - hSelMargin;
+                } else {
+                    hSelEnd = h - SEL_MARGIN;
+                }
+                // The column sums since the last reset
+                colSumsAt(h, colSums);
+                colSumsAt(lastReset, prefixAt);
+                for (int w = 0; w < width; w++) {
+                    colSums[w] -= prefixAt[w];
+                }
+
+                // We have the end of the vertical selection
+                // now figure out the horizontal part of the selection
+                for (int w = 0; w <= width; w++) { // colSums[width] will be 0
+                    if ((colSums[w] / (h - hSelStart)) > SUM_TRIGGER) {
+                        if (wSelStart < 0) {
+                            if (wSelMargin < SEL_MARGIN) {
+                                wSelMargin++;
+                            }
+                            if (wSelMargin == SEL_MARGIN) {
+                                wSelStart = w - SEL_MARGIN + 1;
+                            }
+                        }
+                    } else {
+                        if (wSelStart >= 0) {
+                            if (wSelMargin > 0) {
+                                wSelMargin--;
+                            }
+                        }
+                        if ((wSelStart >= 0) && ((wSelMargin == 0) || (w == width))) {
+                            if (w == width) {
+                                wSelEnd = width;
+                            } else {
+                                wSelEnd = w - SEL_MARGIN + 1;
+                            }
+
+                            // we have the end of a horizontal selection
+                            if ((wSelEnd - wSelStart) < width) {
+                                // skip selections that span the whole width
+                                // calculate the coordinates in the original size
+                                int x1 = wSelStart / multiplier;
+                                int y1 = hSelStart / multiplier;
+                                int x2 = wSelEnd / multiplier;
+                                int y2 = hSelEnd / multiplier;
+                                float selArea = (float)(wSelEnd - wSelStart) * (float)(hSelEnd - hSelStart);
+                                if (selArea > (area * MIN_AREA_SIZE)) {
+                                    selections.append(QRectF(QRect(QPoint(x1, y1), QPoint(x2, y2))));
+                                }
+                            }
+                            wSelStart = -1;
+                            wSelEnd = -1;
+                            wSelMargin = 0;
+                        }
+                    }
+                }
+                hSelStart = -1;
+                hSelEnd = -1;
+                hSelMargin = 0;
+                lastReset = h;
+                colSums.fill(0);
+            }
+        }
+    }
+
+    if (selections.size() > MAX_NUM_SELECTIONS) {
+        // smaller area or should we give up??
+        //findSelections(area/2);
+        // instead of trying to find probably broken selections just give up
+        // and do not force broken selections on the user.
+        selections.clear();
+    }
+    return selections;
+}
+
+// fromRow is the row to start the iterations from. fromRow can be grater than toRow.
+// rowStart is the x1 coordinate of the row
+// all parameters are corrected to be valid pixel indexes,
+// but start must be < end
+static int refineRow(const QImage &img, int fromRow, int toRow, int colStart, int colEnd)
+{
+    int pix;
+    int diff;
+    float rowTrigger;
+    int row;
+    int addSub = (fromRow < toRow) ? 1 : -1;
+
+    colStart -= 2; //add some margin
+    colEnd += 2; //add some margin
+
+    if (colStart < 1) {
+        colStart = 1;
+    }
+    if (colEnd >= img.width() - 1) {
+        colEnd = img.width() - 2;
+    }
+
+    if (fromRow < 1) {
+        fromRow = 1;
+    }
+    if (fromRow >= img.height() - 1) {
+        fromRow = img.height() - 2;
+    }
+
+    if (toRow < 1) {
+        toRow = 1;
+    }
+    if (toRow >= img.height() - 1) {
+        toRow = img.height() - 2;
+    }
+
+    row = fromRow;
+    while (row != toRow) {
+        const QRgb *prev = imgLine(img, row - 1);
+        const QRgb *line = imgLine(img, row);
+        const QRgb *next = imgLine(img, row + 1);
+        rowTrigger = 0;
+        for (int w = colStart; w < colEnd; w++) {
+            diff = 0;
+            pix = qGray(line[w]);
+            // how much does the pixel differ from the surrounding
+            diff += qAbs(pix - qGray(line[w - 1]));
+            diff += qAbs(pix - qGray(line[w + 1]));
+            diff += qAbs(pix - qGray(prev[w]));
+            diff += qAbs(pix - qGray(next[w]));
+            if (diff <= DIFF_TRIGGER) {
+                diff = 0;
+            }
+
+            rowTrigger = ((rowTrigger * AVERAGE_MULT) + diff) / AVERAGE_COUNT;
+
+            if (rowTrigger > AVERAGE_TRIGGER) {
+                break;
+            }
+        }
+
+        if (rowTrigger > AVERAGE_TRIGGER) {
+            // row == 1 _probably_ means that the selection should start from 0
+            // but that can not be detected if we start from 1 => include one extra column
+            if (row == 1) {
+                row = 0;
+            }
+            if (row == (img.width() - 2)) {
+                row = img.width();
+            }
+            return row;
+        }
+        row += addSub;
+    }
+    return row;
+}
+
+static int refineColumn(const QImage &img, int fromCol, int toCol, int rowStart, int rowEnd)
+{
+    int pix;
+    int diff;
+    float colTrigger;
+    int col;
+    int addSub = (fromCol < toCol) ? 1 : -1;
+
+    rowStart -= 2; //add some margin
+    rowEnd += 2; //add some margin
+
+    if (rowStart < 1) {
+        rowStart = 1;
+    }
+    if (rowEnd >= img.height() - 1) {
+        rowEnd = img.height() - 2;
+    }
+
+    if (fromCol < 1) {
+        fromCol = 1;
+    }
+    if (fromCol >= img.width() - 1) {
+        fromCol = img.width() - 2;
+    }
+
+    if (toCol < 1) {
+        toCol = 1;
+    }
+    if (toCol >= img.width() - 1) {
+        toCol = img.width() - 2;
+    }
+
+    col = fromCol;
+    while (col != toCol) {
+        colTrigger = 0;
+        for (int row = rowStart; row < rowEnd; row++) {
+            const QRgb *line = imgLine(img, row);
+            diff = 0;
+            pix = qGray(line[col]);
+            // how much does the pixel differ from the surrounding
+            diff += qAbs(pix - qGray(line[col - 1]));
+            diff += qAbs(pix - qGray(line[col + 1]));
+            diff += qAbs(pix - qGray(imgLine(img, row - 1)[col]));
+            diff += qAbs(pix - qGray(imgLine(img, row + 1)[col]));
+            if (diff <= DIFF_TRIGGER) {
+                diff = 0;
+            }
+
+            colTrigger = ((colTrigger * AVERAGE_MULT) + diff) / AVERAGE_COUNT;
+
+            if (colTrigger > AVERAGE_TRIGGER) {
+                break;
+            }
+        }
+
+        if (colTrigger > AVERAGE_TRIGGER) {
+            // col == 1 _probably_ means that the selection should start from 0
+            // but that can not be detected if we start from 1 => include one extra column
+            if (col == 1) {
+                col = 0;
+            }
+            if (col == (img.width() - 2)) {
+                col = img.width();
+            }
+            return col;
+        }
+        col += addSub;
+    }
+    return col;
+}
+
+void KSaneSelectionFinder::refineSelections(const QImage &orig, QList<QRectF> &selections, int pixelMargin)
+{
+    // The end result
+    int hSelStart;
+    int hSelEnd;
+    int wSelStart;
+    int wSelEnd;
+
+    if ((orig.width() < 3) || (orig.height() < 3)) {
+        return;
+    }
+    QImage img = rgb32Image(orig);
+
+    for (int i = 0; i < selections.size(); i++) {
+        QRectF selRect = selections.at(i);
+
+        // original values
+        hSelStart = (int)selRect.top();
+        hSelEnd = (int)selRect.bottom();
+        wSelStart = (int)selRect.left();
+        wSelEnd = (int)selRect.right();
+
+        // Top
+        // Too long iteration should not be a problem since the loop should be interrupted by the limit
+        hSelStart = refineRow(img, hSelStart - pixelMargin, hSelEnd, wSelStart, wSelEnd);
+
+        // Bottom (from the bottom up wards)
+        hSelEnd = refineRow(img, hSelEnd + pixelMargin, hSelStart, wSelStart, wSelEnd);
+
+        // Left
+        wSelStart = refineColumn(img, wSelStart - pixelMargin, wSelEnd, hSelStart, hSelEnd);
+
+        // Right
+        wSelEnd = refineColumn(img, wSelEnd + pixelMargin, wSelStart, hSelStart, hSelEnd);
+
+        // Now update the selection
+        selections[i] = QRectF(QPointF(wSelStart, hSelStart), QPointF(wSelEnd, hSelEnd));
+    }
+}
+
+}  // NameSpace KSaneIface
@@ -0,0 +1,100 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Automatic selection detection for preview images
+ *
+ * Copyright (C) 2010 by Kare Sars <kare dot sars at iki dot fi>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#ifndef KSANE_SELECTION_FINDER_H
+#define KSANE_SELECTION_FINDER_H
+
+#include <QObject>
+#include <QImage>
+#include <QList>
+#include <QRectF>
+#include <QFutureWatcher>
+
+namespace KSaneIface
+{
+
+/**
+ * This class finds the areas of a preview image that contain something
+ * (photos, documents, ...) and should be scanned separately.
+ *
+ * The detection runs on the global thread pool so that the GUI thread is not
+ * blocked. The gradient phase is split into horizontal bands that are
+ * calculated in parallel and merged before the selections are extracted.
+ */
+class KSaneSelectionFinder : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit KSaneSelectionFinder(QObject *parent = nullptr);
+    ~KSaneSelectionFinder();
+
+    /** Start finding selections in the background. selectionsFound() is emitted when done.
+     * A running search is abandoned if a new one is started.
+     * \param img is the image to search. The image is shallow copied.
+     * \param area is the area of the reduced sized image that is used for the coarse search. */
+    void start(const QImage &img, float area = 10000.0);
+
+    /** Abandon a running search. selectionsFound() will not be emitted for it. */
+    void cancel();
+
+    bool isRunning() const;
+
+    /** Coarse detection on a reduced size image.
+     * \param img is the image to search.
+     * \param area is the area of the reduced sized image.
+     * \param pixelMargin returns the error margin caused by the size reduction in pixels of img.
+     * \return the found selections in pixel coordinates of img or an empty list if
+     * there are too many selections to be trusted. */
+    static QList<QRectF> detectSelections(const QImage &img, float area, int &pixelMargin);
+
+    /** Refine the coarse selections on the full size image.
+     * \param pixelMargin is the margin returned by detectSelections(). */
+    static void refineSelections(const QImage &img, QList<QRectF> &selections, int pixelMargin);
+
+    /** Remove the selections that are too small compared to img. */
+    static void removeSmallSelections(const QImage &img, QList<QRectF> &selections);
+
+    /** Synchronous detection + refinement + filtering of too small selections. */
+    static QList<QRectF> findSelections(const QImage &img, float area);
+
+Q_SIGNALS:
+    /** This signal is emitted in the thread of this object when a search is done.
+     * \param selections are the found selections in pixel coordinates of the searched image. */
+    void selectionsFound(const QList<QRectF> &selections);
+
+private Q_SLOTS:
+    void searchDone();
+
+private:
+    QFutureWatcher<QList<QRectF> > m_watcher;
+    bool                           m_active;
+};
+
+}  // NameSpace KSaneIface
+
+#endif
@@ -0,0 +1,190 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#include "ksanestatisticsstage.h"
+
+#include "ksanecore.h"
+
+#include <QVariant>
+
+namespace KSaneIface
+{
+
+KSaneChannelStatistics::KSaneChannelStatistics()
+    : minimum(0),
+      maximum(0),
+      mean(0.0)
+{
+}
+
+struct KSaneStatisticsStage::Private {
+    int                       format;
+    int                       width;
+    qint64                    pixels;
+    QVector<QVector<quint32>> histograms;
+};
+
+KSaneStatisticsStage::KSaneStatisticsStage()
+    : d(new Private)
+{
+    qRegisterMetaType<KSaneIface::KSanePageStatistics>();
+    d->format = KSaneCore::FormatNone;
+    d->width  = 0;
+    d->pixels = 0;
+}
+
+KSaneStatisticsStage::~KSaneStatisticsStage()
+{
+    delete d;
+}
+
+void KSaneStatisticsStage::beginPage(const KSanePage &page)
+{
+    int channels = 0;
+    int bins = 0;
+    switch (page.format) {
+    case KSaneCore::FormatBlackWhite:
+        channels = 1;
+        bins = 2;
+        break;
+    case KSaneCore::FormatGrayScale8:
+        channels = 1;
+        bins = 256;
+        break;
+    case KSaneCore::FormatGrayScale16:
+        channels = 1;
+        bins = 65536;
+        break;
+    case KSaneCore::FormatRGB_8_C:
+        channels = 3;
+        bins = 256;
+        break;
+    case KSaneCore::FormatRGB_16_C:
+        channels = 3;
+        bins = 65536;
+        break;
+    default:
+        break;
+    }
+
+    d->format = page.format;
+    d->width  = page.width;
+    d->pixels = 0;
+    d->histograms.clear();
+    for (int i = 0; i < channels; i++) {
+        d->histograms.append(QVector<quint32>(bins, 0));
+    }
+}
+
+void KSaneStatisticsStage::processRows(char *rows, int, int rowCount, int bytesPerLine)
+{
+    if (d->histograms.isEmpty()) {
+        return;
+    }
+
+    // the histograms are not detached for every pixel
+    quint32 *hist0 = d->histograms[0].data();
+    quint32 *hist1 = (d->histograms.size() == 3) ? d->histograms[1].data() : nullptr;
+    quint32 *hist2 = (d->histograms.size() == 3) ? d->histograms[2].data() : nullptr;
+
+    for (int row = 0; row < rowCount; row++) {
+        const uchar *line = reinterpret_cast<const uchar *>(rows) + ((qint64)row * bytesPerLine);
+        switch (d->format) {
+        case KSaneCore::FormatBlackWhite:
+            for (int x = 0; x < d->width; x++) {
+                hist0[(line[x >> 3] >> (7 - (x & 7))) & 1]++;
+            }
+            break;
+        case KSaneCore::FormatGrayScale8:
+            for (int x = 0; x < d->width; x++) {
+                hist0[line[x]]++;
+            }
+            break;
+        case KSaneCore::FormatGrayScale16: {
+            const quint16 *line16 = reinterpret_cast<const quint16 *>(line);
+            for (int x = 0; x < d->width; x++) {
+                hist0[line16[x]]++;
+            }
+            break;
+        }
+        case KSaneCore::FormatRGB_8_C:
+            for (int x = 0; x < d->width; x++) {
+                hist0[line[0]]++;
+                hist1[line[1]]++;
+                hist2[line[2]]++;
+                line += 3;
+            }
+            break;
+        case KSaneCore::FormatRGB_16_C: {
+            const quint16 *line16 = reinterpret_cast<const quint16 *>(line);
+            for (int x = 0; x < d->width; x++) {
+                hist0[line16[0]]++;
+                hist1[line16[1]]++;
+                hist2[line16[2]]++;
+                line16 += 3;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    d->pixels += (qint64)rowCount * d->width;
+}
+
+void KSaneStatisticsStage::endPage(KSanePage &page)
+{
+    KSanePageStatistics statistics;
+    statistics.pixels = d->pixels;
+
+    for (int i = 0; i < d->histograms.size(); i++) {
+        KSaneChannelStatistics channel;
+        channel.histogram = d->histograms.at(i);
+
+        const QVector<quint32> &histogram = channel.histogram;
+        double sum = 0.0;
+        bool first = true;
+        for (int value = 0; value < histogram.size(); value++) {
+            if (histogram.at(value) == 0) {
+                continue;
+            }
+            if (first) {
+                channel.minimum = value;
+                first = false;
+            }
+            channel.maximum = value;
+            sum += (double)value * histogram.at(value);
+        }
+        if (d->pixels > 0) {
+            channel.mean = sum / d->pixels;
+        }
+        statistics.channels.append(channel);
+    }
+    d->histograms.clear();
+
+    page.properties.insert(QStringLiteral("statistics"), QVariant::fromValue(statistics));
+}
+
+}  // NameSpace KSaneIface
@@ -0,0 +1,83 @@
+/* ============================================================
+ *
+ * This file is part of the KDE project
+ *
+ * Date        : 2026-10-19
+ * Description : Sane interface for KDE
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ============================================================ */
+
+#ifndef KSANE_STATISTICS_STAGE_H
+#define KSANE_STATISTICS_STAGE_H
+
+#include "ksanecore_export.h"
+#include "ksanepipeline.h"
+
+#include <QVector>
+#include <QMetaType>
+
+namespace KSaneIface
+{
+
+/** The statistics of one color channel of a page. */
+struct KSaneChannelStatistics {
+    KSaneChannelStatistics();
+
+    QVector<quint32> histogram; ///< 2 entries for line-art, 256 for 8 bit and 65536 for 16 bit data
+    int              minimum;   ///< the smallest value in the channel
+    int              maximum;   ///< the largest value in the channel
+    double           mean;
+};
+
+/** The statistics of a page. There is one channel for gray and line-art pages
+ * and three (red, green, blue) for color pages. */
+struct KSanePageStatistics {
+    QVector<KSaneChannelStatistics> channels;
+    qint64                          pixels;     ///< the number of pixels per channel
+};
+
+/**
+ * This row stage computes the histograms of the color channels while the rows are read,
+ * so that auto-levels or exposure checks do not need another pass over the image.
+ * The minimum, maximum and mean are computed from the histograms at the end of the page.
+ *
+ * The result is stored in the property "statistics" of the page as KSanePageStatistics.
+ * For line-art the value 1 is black, as in the data.
+ */
+class KSANECORE_EXPORT KSaneStatisticsStage : public KSaneRowStage
+{
+public:
+    KSaneStatisticsStage();
+    ~KSaneStatisticsStage();
+
+    void beginPage(const KSanePage &page) override;
+    void processRows(char *rows, int firstRow, int rowCount, int bytesPerLine) override;
+    void endPage(KSanePage &page) override;
+
+private:
+    Q_DISABLE_COPY(KSaneStatisticsStage)
+    struct Private;
+    Private *const d;
+};
+
+}  // NameSpace KSaneIface
+
+Q_DECLARE_METATYPE(KSaneIface::KSanePageStatistics)
+
+#endif // KSANE_STATISTICS_STAGE_H
@@ -30,6 +30,7 @@
 
 #include "selectionitem.h"
 #include "hiderectitem.h"
+#include "ksaneselectionfinder.h"
 
 #include <QGraphicsPixmapItem>
 #include <QGraphicsScene>
@@ -40,6 +41,7 @@
 #include <QList>
 #include <QVector>
 #include <QIcon>
+#include <QPainterPath>
 
 #include <KLocalizedString>
 
@@ -72,6 +74,8 @@ struct KSaneViewer::Private {
     HideRectItem *hideBottom;
     HideRectItem *hideArea;
 
+    KSaneSelectionFinder *finder;
+
     int wheelDelta = 0;
 };
 
@@ -114,6 +118,9 @@ KSaneViewer::KSaneViewer(QImage *img, QWidget *parent) : QGraphicsView(parent),
     d->change = SelectionItem::None;
     d->selectionList.clear();
 
+    d->finder = new KSaneSelectionFinder(this);
+    connect(d->finder, &KSaneSelectionFinder::selectionsFound, this, &KSaneViewer::selectionsFound);
+
     // create context menu
     d->zoomInAction = new QAction(QIcon::fromTheme(QLatin1String("zoom-in")), i18n("Zoom In"), this);
     connect(d->zoomInAction, &QAction::triggered, this, &KSaneViewer::zoomIn);
@@ -296,6 +303,7 @@ void KSaneViewer::setSelection(float tl_x, float tl_y, float br_x, float br_y)
 
     d->selection->setRect(rect);
     updateSelVisibility();
+    emit selectionsChanged();
 }
 
 // ------------------------------------------------------------------------
@@ -509,9 +517,12 @@ void KSaneViewer::clearSavedSelections()
 // ------------------------------------------------------------------------
 void KSaneViewer::clearSelections()
 {
+    // results of a running search would belong to the old image
+    d->finder->cancel();
     clearActiveSelection();
     clearSavedSelections();
     updateSelVisibility();
+    emit selectionsChanged();
 }
 
 // ------------------------------------------------------------------------
@@ -612,6 +623,9 @@ void KSaneViewer::mouseReleaseEvent(QMouseEvent *e)
         emit newSelection(tlx, tly, brx, bry);
     }
     updateHighlight();
+    if (e->button() == Qt::LeftButton) {
+        emit selectionsChanged();
+    }
     QGraphicsView::mouseReleaseEvent(e);
 }
 
@@ -786,375 +800,30 @@ void KSaneViewer::mouseMoveEvent(QMouseEvent *e)
     QGraphicsView::mouseMoveEvent(e);
 }
 
-// The change trigger before adding to the sum
-static const int DIFF_TRIGGER = 8;
-
-// The selection start/stop level trigger
-static const int SUM_TRIGGER = 4;
-
-// The selection start/stop level trigger for the floating  average
-static const int AVERAGE_TRIGGER = 7;
-
-// The selection start/stop margin
-static const int SEL_MARGIN = 3;
-
-// Maximum number of allowed selections (this could be a settable variable)
-static const int MAX_NUM_SELECTIONS = 8;
-
-// floating average 'div' must be one less than 'count'
-static const int AVERAGE_COUNT = 50;
-static const int AVERAGE_MULT = 49;
-
-// Minimum selection area compared to the whole image
-static const float MIN_AREA_SIZE = 0.01;
 // ------------------------------------------------------------------------
 void KSaneViewer::findSelections(float area)
 {
-    // Reduce the size of the image to decrease noise and calculation time
-    float multiplier = sqrt(area / (d->img->height() * d->img->width()));
-
-    int width  = (int)(d->img->width() * multiplier);
-    int height = (int)(d->img->height() * multiplier);
-
-    QImage img = d->img->scaled(width, height, Qt::KeepAspectRatio);
-    height = img.height(); // the size was probably not exact
-    width  = img.width();
-
-    QVector<qint64> colSums(width + SEL_MARGIN + 1);
-    qint64 rowSum;
-    colSums.fill(0);
-    int pix;
-    int diff;
-    int hSelStart = -1;
-    int hSelEnd = -1;
-    int hSelMargin = 0;
-    int wSelStart = -1;
-    int wSelEnd = -1;
-    int wSelMargin = 0;
-
-    for (int h = 1; h < height; h++) {
-        rowSum = 0;
-        if (h < height - 1) {
-            // Special case for the left most pixel
-            pix = qGray(img.pixel(0, h));
-            diff  = qAbs(pix - qGray(img.pixel(1, h)));
-            diff += qAbs(pix - qGray(img.pixel(0, h - 1)));
-            diff += qAbs(pix - qGray(img.pixel(0, h + 1)));
-            if (diff > DIFF_TRIGGER) {
-                colSums[0] += diff;
-                rowSum += diff;
-            }
-
-            // Special case for the right most pixel
-            pix = qGray(img.pixel(width - 1, h));
-            diff  = qAbs(pix - qGray(img.pixel(width - 2, h)));
-            diff += qAbs(pix - qGray(img.pixel(width - 1, h - 1)));
-            diff += qAbs(pix - qGray(img.pixel(width - 1, h + 1)));
-            if (diff > DIFF_TRIGGER) {
-                colSums[width - 1] += diff;
-                rowSum += diff;
-            }
-
-            for (int w = 1; w < (width - 1); w++) {
-                pix = qGray(img.pixel(w, h));
-                diff = 0;
-                // how much does the pixel differ from the surrounding
-                diff += qAbs(pix - qGray(img.pixel(w - 1, h)));
-                diff += qAbs(pix - qGray(img.pixel(w + 1, h)));
-                diff += qAbs(pix - qGray(img.pixel(w, h - 1)));
-                diff += qAbs(pix - qGray(img.pixel(w, h + 1)));
-                if (diff > DIFF_TRIGGER) {
-                    colSums[w] += diff;
-                    rowSum += diff;
-                }
-            }
-        }
-
-        if ((rowSum / width) > SUM_TRIGGER) {
-            if (hSelStart < 0) {
-                if (hSelMargin < SEL_MARGIN) {
-                    hSelMargin++;
-                }
-                if (hSelMargin == SEL_MARGIN) {
-                    hSelStart = h - SEL_MARGIN + 1;
-                }
-            }
-        } else {
-            if (hSelStart >= 0) {
-                if (hSelMargin > 0) {
-                    hSelMargin--;
-                }
-            }
-            if ((hSelStart > -1) && ((hSelMargin == 0) || (h == height - 1))) {
-                if (h == height - 1) {
-                    hSelEnd = h - hSelMargin;
-                } else {
-                    hSelEnd = h - SEL_MARGIN;
-                }
-                // We have the end of the vertical selection
-                // now figure out the horizontal part of the selection
-                for (int w = 0; w <= width; w++) { // colSums[width] will be 0
-                    if ((colSums[w] / (h - hSelStart)) > SUM_TRIGGER) {
-                        if (wSelStart < 0) {
-                            if (wSelMargin < SEL_MARGIN) {
-                                wSelMargin++;
-                            }
-                            if (wSelMargin == SEL_MARGIN) {
-                                wSelStart = w - SEL_MARGIN + 1;
-                            }
-                        }
-                    } else {
-                        if (wSelStart >= 0) {
-                            if (wSelMargin > 0) {
-                                wSelMargin--;
-                            }
-                        }
-                        if ((wSelStart >= 0) && ((wSelMargin == 0) || (w == width))) {
-                            if (w == width) {
-                                wSelEnd = width;
-                            } else {
-                                wSelEnd = w - SEL_MARGIN + 1;
-                            }
-
-                            // we have the end of a horizontal selection
-                            if ((wSelEnd - wSelStart) < width) {
-                                // skip selections that span the whole width
-                                // calculate the coordinates in the original size
-                                int x1 = wSelStart / multiplier;
-                                int y1 = hSelStart / multiplier;
-                                int x2 = wSelEnd / multiplier;
-                                int y2 = hSelEnd / multiplier;
-                                float selArea = (float)(wSelEnd - wSelStart) * (float)(hSelEnd - hSelStart);
-                                if (selArea > (area * MIN_AREA_SIZE)) {
-                                    SelectionItem *tmp = new SelectionItem(QRect(QPoint(x1, y1), QPoint(x2, y2)));
-                                    tmp->setDevicePixelRatio(d->img->devicePixelRatio());
-                                    d->selectionList.push_back(tmp);
-                                    d->selectionList.back()->setSaved(true);
-                                    d->selectionList.back()->saveZoom(transform().m11());
-                                    d->scene->addItem(d->selectionList.back());
-                                    d->selectionList.back()->setZValue(9);
-                                }
-                            }
-                            wSelStart = -1;
-                            wSelEnd = -1;
-                            (void)hSelEnd;    // clang static analyzer report hSelEnd is never used.
-                            wSelMargin = 0;
-                        }
-                    }
-                }
-                hSelStart = -1;
-                hSelEnd = -1;
-                hSelMargin = 0;
-                colSums.fill(0);
-            }
-        }
-    }
-
-    if (d->selectionList.size() > MAX_NUM_SELECTIONS) {
-        // smaller area or should we give up??
-        clearSavedSelections();
-        //findSelections(area/2);
-        // instead of trying to find probably broken selections just give up
-        // and do not force broken selections on the user.
-    } else {
-        // 1/multiplier is the error margin caused by the resolution reduction
-        refineSelections(qRound(1 / multiplier));
-        // check that the selections are big enough
-        float minArea = d->img->height() * d->img->width() * MIN_AREA_SIZE;
-
-        int i = 0;
-        while (i < d->selectionList.size()) {
-            if ((d->selectionList[i]->rect().width() * d->selectionList[i]->rect().height()) < minArea) {
-                d->scene->removeItem(d->selectionList[i]);
-                d->selectionList.removeAt(i);
-            } else {
-                i++;
-            }
-        }
-    }
+    d->finder->start(*d->img, area);
 }
 
-QSize KSaneViewer::sizeHint() const
-{
-    return QSize(250, 300);  // a sensible size for a scan preview
-}
-
-void KSaneViewer::refineSelections(int pixelMargin)
-{
-    // The end result
-    int hSelStart;
-    int hSelEnd;
-    int wSelStart;
-    int wSelEnd;
-
-    for (int i = 0; i < d->selectionList.size(); i++) {
-        QRectF selRect = d->selectionList.at(i)->rect();
-
-        // original values
-        hSelStart = (int)selRect.top();
-        hSelEnd = (int)selRect.bottom();
-        wSelStart = (int)selRect.left();
-        wSelEnd = (int)selRect.right();
-
-        // Top
-        // Too long iteration should not be a problem since the loop should be interrupted by the limit
-        hSelStart = refineRow(hSelStart - pixelMargin, hSelEnd, wSelStart, wSelEnd);
-
-        // Bottom (from the bottom up wards)
-        hSelEnd = refineRow(hSelEnd + pixelMargin, hSelStart, wSelStart, wSelEnd);
-
-        // Left
-        wSelStart = refineColumn(wSelStart - pixelMargin, wSelEnd, hSelStart, hSelEnd);
-
-        // Right
-        wSelEnd = refineColumn(wSelEnd + pixelMargin, wSelStart, hSelStart, hSelEnd);
-
-        // Now update the selection
-        d->selectionList.at(i)->setRect(QRectF(QPointF(wSelStart, hSelStart), QPointF(wSelEnd, hSelEnd)));
-    }
-}
-
-int KSaneViewer::refineRow(int fromRow, int toRow, int colStart, int colEnd)
+// ------------------------------------------------------------------------
+void KSaneViewer::selectionsFound(const QList<QRectF> &selections)
 {
-    int pix;
-    int diff;
-    float rowTrigger;
-    int row;
-    int addSub = (fromRow < toRow) ? 1 : -1;
-
-    colStart -= 2; //add some margin
-    colEnd += 2; //add some margin
-
-    if (colStart < 1) {
-        colStart = 1;
-    }
-    if (colEnd >= d->img->width() - 1) {
-        colEnd = d->img->width() - 2;
-    }
-
-    if (fromRow < 1) {
-        fromRow = 1;
-    }
-    if (fromRow >= d->img->height() - 1) {
-        fromRow = d->img->height() - 2;
-    }
-
-    if (toRow < 1) {
-        toRow = 1;
-    }
-    if (toRow >= d->img->height() - 1) {
-        toRow = d->img->height() - 2;
-    }
-
-    row = fromRow;
-    while (row != toRow) {
-        rowTrigger = 0;
-        for (int w = colStart; w < colEnd; w++) {
-            diff = 0;
-            pix = qGray(d->img->pixel(w, row));
-            // how much does the pixel differ from the surrounding
-            diff += qAbs(pix - qGray(d->img->pixel(w - 1, row)));
-            diff += qAbs(pix - qGray(d->img->pixel(w + 1, row)));
-            diff += qAbs(pix - qGray(d->img->pixel(w, row - 1)));
-            diff += qAbs(pix - qGray(d->img->pixel(w, row + 1)));
-            if (diff <= DIFF_TRIGGER) {
-                diff = 0;
-            }
-
-            rowTrigger = ((rowTrigger * AVERAGE_MULT) + diff) / AVERAGE_COUNT;
-
-            if (rowTrigger > AVERAGE_TRIGGER) {
-                break;
-            }
-        }
-
-        if (rowTrigger > AVERAGE_TRIGGER) {
-            // row == 1 _probably_ means that the selection should start from 0
-            // but that can not be detected if we start from 1 => include one extra column
-            if (row == 1) {
-                row = 0;
-            }
-            if (row == (d->img->width() - 2)) {
-                row = d->img->width();
-            }
-            return row;
-        }
-        row += addSub;
+    for (int i = 0; i < selections.size(); i++) {
+        SelectionItem *tmp = new SelectionItem(selections.at(i));
+        tmp->setDevicePixelRatio(d->img->devicePixelRatio());
+        d->selectionList.push_back(tmp);
+        d->selectionList.back()->setSaved(true);
+        d->selectionList.back()->saveZoom(transform().m11());
+        d->scene->addItem(d->selectionList.back());
+        d->selectionList.back()->setZValue(9);
     }
-    return row;
+    emit selectionsChanged();
 }
 
-int KSaneViewer::refineColumn(int fromCol, int toCol, int rowStart, int rowEnd)
+QSize KSaneViewer::sizeHint() const
 {
-    int pix;
-    int diff;
-    float colTrigger;
-    int col;
-    int count;
-    int addSub = (fromCol < toCol) ? 1 : -1;
-
-    rowStart -= 2; //add some margin
-    rowEnd += 2; //add some margin
-
-    if (rowStart < 1) {
-        rowStart = 1;
-    }
-    if (rowEnd >= d->img->height() - 1) {
-        rowEnd = d->img->height() - 2;
-    }
-
-    if (fromCol < 1) {
-        fromCol = 1;
-    }
-    if (fromCol >= d->img->width() - 1) {
-        fromCol = d->img->width() - 2;
-    }
-
-    if (toCol < 1) {
-        toCol = 1;
-    }
-    if (toCol >= d->img->width() - 1) {
-        toCol = d->img->width() - 2;
-    }
-
-    col = fromCol;
-    while (col != toCol) {
-        colTrigger = 0;
-        count = 0;
-        for (int row = rowStart; row < rowEnd; row++) {
-            count++;
-            diff = 0;
-            pix = qGray(d->img->pixel(col, row));
-            // how much does the pixel differ from the surrounding
-            diff += qAbs(pix - qGray(d->img->pixel(col - 1, row)));
-            diff += qAbs(pix - qGray(d->img->pixel(col + 1, row)));
-            diff += qAbs(pix - qGray(d->img->pixel(col, row - 1)));
-            diff += qAbs(pix - qGray(d->img->pixel(col, row + 1)));
-            if (diff <= DIFF_TRIGGER) {
-                diff = 0;
-            }
-
-            colTrigger = ((colTrigger * AVERAGE_MULT) + diff) / AVERAGE_COUNT;
-
-            if (colTrigger > AVERAGE_TRIGGER) {
-                break;
-            }
-        }
-
-        if (colTrigger > AVERAGE_TRIGGER) {
-            // col == 1 _probably_ means that the selection should start from 0
-            // but that can not be detected if we start from 1 => include one extra column
-            if (col == 1) {
-                col = 0;
-            }
-            if (col == (d->img->width() - 2)) {
-                col = d->img->width();
-            }
-            return col;
-        }
-        col += addSub;
-    }
-    return col;
+    return QSize(250, 300);  // a sensible size for a scan preview
 }
 
 QPointF KSaneViewer::scenePos(QMouseEvent *e) const
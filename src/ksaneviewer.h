@@ -43,7 +43,8 @@ public:
 
     void setQImage(QImage *img);
     void updateImage();
-    /** Find selections in the picture
+    /** Find selections in the picture. The search is done in the background and
+    * the found selections are added as saved selections when it is done.
     * \param area this parameter determine the area of the reduced sized image. */
     void findSelections(float area = 10000.0);
 
@@ -94,6 +95,8 @@ public Q_SLOTS:
 
 Q_SIGNALS:
     void newSelection(float tl_x, float tl_y, float br_x, float br_y);
+    /** This signal is emitted when the active selection or the saved selections have changed. */
+    void selectionsChanged();
 
 protected:
     void wheelEvent(QWheelEvent *e) override;
@@ -102,18 +105,13 @@ protected:
     void mouseMoveEvent(QMouseEvent *e) override;
     void drawBackground(QPainter *painter, const QRectF &rect) override;
 
+private Q_SLOTS:
+    void selectionsFound(const QList<QRectF> &selections);
+
 private:
     void updateSelVisibility();
     void updateHighlight();
     bool activeSelection(float &tl_x, float &tl_y, float &br_x, float &br_y);
-    void refineSelections(int pixelMargin);
-
-    // fromRow is the row to start the iterations from. fromRow can be grater than toRow.
-    // rowStart is the x1 coordinate of the row
-    // all parameters are corrected to be valid pixel indexes,
-    // but start must be < end
-    int  refineRow(int fromRow, int toRow, int rowStart, int rowEnd);
-    int  refineColumn(int fromCol, int toCol, int colStart, int colEnd);
 
     QPointF scenePos(QMouseEvent *e) const;
 
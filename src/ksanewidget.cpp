@@ -40,6 +40,7 @@
 #include <QSplitter>
 #include <QMutex>
 #include <QPointer>
+#include <QMetaMethod>
 #include <QDebug>
 #include <QIcon>
 
@@ -57,6 +58,8 @@
 #include "ksaneoptgamma.h"
 #include "ksaneoptslider.h"
 #include "ksanedevicedialog.h"
+#include "ksanecore.h"
+#include "ksanehandlepool.h"
 #include "labeledgamma.h"
 
 namespace KSaneIface
@@ -69,25 +72,10 @@ static const QString InvetColorsOption = QStringLiteral("KSane::InvertColors");
 KSaneWidget::KSaneWidget(QWidget *parent)
     : QWidget(parent), d(new KSaneWidgetPrivate(this))
 {
-    SANE_Int    version;
-    SANE_Status status;
+    KSaneCore::initSane();
 
     s_objectMutex.lock();
     s_objectCount++;
-
-    if (s_objectCount == 1) {
-        // only call sane init for the first instance
-        status = sane_init(&version, &KSaneAuth::authorization);
-        if (status != SANE_STATUS_GOOD) {
-            qDebug() << "libksane: sane_init() failed("
-                     << sane_strstatus(status) << ")";
-        } else {
-            //qDebug() << "Sane Version = "
-            //         << SANE_VERSION_MAJOR(version) << "."
-            //         << SANE_VERSION_MINORparent(version) << "."
-            //         << SANE_VERSION_BUILD(version);
-        }
-    }
     s_objectMutex.unlock();
 
     // read the device list to get a list of vendor and model info
@@ -105,6 +93,7 @@ KSaneWidget::KSaneWidget(QWidget *parent)
     d->m_previewViewer = new KSaneViewer(&(d->m_previewImg), this);
     connect(d->m_previewViewer, SIGNAL(newSelection(float,float,float,float)),
             d, SLOT(handleSelection(float,float,float,float)));
+    connect(d->m_previewViewer, SIGNAL(selectionsChanged()), d, SLOT(armButtonScan()));
 
     d->m_warmingUp = new QLabel;
     d->m_warmingUp->setText(i18n("Waiting for the scan to start."));
@@ -218,6 +207,9 @@ KSaneWidget::KSaneWidget(QWidget *parent)
     d->m_otherScrollA->setWidgetResizable(true);
     d->m_otherScrollA->setFrameShape(QFrame::NoFrame);
     d->m_optsTabWidget->addTab(d->m_otherScrollA, i18n("Scanner Specific Options"));
+    // the options on a hidden tab are not polled
+    connect(d->m_optsTabWidget, SIGNAL(currentChanged(int)), d, SLOT(createOtherOptions()));
+    connect(d->m_optsTabWidget, SIGNAL(currentChanged(int)), d, SLOT(updatePollList()));
 
     d->m_splitter = new QSplitter(this);
     d->m_splitter->addWidget(d->m_optsTabWidget);
@@ -248,21 +240,24 @@ KSaneWidget::~KSaneWidget()
     s_objectMutex.lock();
     s_objectCount--;
     if (s_objectCount <= 0) {
-        // only delete the find-devices and authorization singletons and call sane_exit
-        // if this is the last instance
+        // only delete the find-devices singleton if this is the last instance
         delete d->m_findDevThread;
-        delete d->m_auth;
-        sane_exit();
     }
     s_objectMutex.unlock();
     delete d;
+    // the authorization singleton is deleted with the last user of SANE
+    KSaneCore::exitSane();
 }
 
 QString KSaneWidget::vendor() const
 {
-    d->m_findDevThread->wait();
-    d->devListUpdated(); // this is just a wrapped if (m_vendor.isEmpty()) statement if the vendor is known
-    // devListUpdated here is to ensure that we do not come in between finished and the devListUpdated slot
+    // the cached list usually knows the device, so there is no need to wait for the thread
+    d->devListUpdated();
+    if (d->m_vendor.isEmpty()) {
+        d->m_findDevThread->wait();
+        d->devListUpdated(); // this is just a wrapped if (m_vendor.isEmpty()) statement if the vendor is known
+        // devListUpdated here is to ensure that we do not come in between finished and the devListUpdated slot
+    }
 
     return d->m_vendor;
 }
@@ -272,13 +267,26 @@ QString KSaneWidget::make() const
 }
 QString KSaneWidget::model() const
 {
-    d->m_findDevThread->wait();
-    d->devListUpdated(); // this is just a wrapped if (m_vendor.isEmpty()) statement if the vendor is known
-    // devListUpdated here is to ensure that we do not come in between finished and the devListUpdated slot
+    d->devListUpdated();
+    if (d->m_vendor.isEmpty()) {
+        d->m_findDevThread->wait();
+        d->devListUpdated(); // this is just a wrapped if (m_vendor.isEmpty()) statement if the vendor is known
+        // devListUpdated here is to ensure that we do not come in between finished and the devListUpdated slot
+    }
 
     return d->m_model;
 }
 
+void KSaneWidget::setDeviceDiscoveryTimeout(int timeoutMsec)
+{
+    FindSaneDevicesThread::setHelperTimeout(timeoutMsec);
+}
+
+void KSaneWidget::setDeviceIdleTimeout(int idleMsec)
+{
+    KSaneHandlePool::setIdleTimeout(idleMsec);
+}
+
 QString KSaneWidget::selectDevice(QWidget *parent)
 {
     QString selected_name;
@@ -305,6 +313,10 @@ void KSaneWidget::initGetDeviceList() const
     } else {
         //qDebug() << "initGetDeviceList() have existing data...";
         d->signalDevListUpdate();
+        if (d->m_findDevThread->isCachedList()) {
+            // check the cached list in the background, devicesChanged() reports the difference
+            d->m_findDevThread->start();
+        }
     }
 }
 
@@ -321,6 +333,7 @@ bool KSaneWidget::openDevice(const QString &deviceName)
 #endif
     QString                        myFolderName = QStringLiteral("ksane");
     QMap<QString, QString>         wallet_entry;
+    QVector<const SANE_Option_Descriptor *> descriptors;
 
     if (d->m_saneHandle != nullptr) {
         // this KSaneWidget already has an open device
@@ -335,7 +348,7 @@ bool KSaneWidget::openDevice(const QString &deviceName)
     d->m_devName = deviceName;
 
     // Try to open the device
-    status = sane_open(deviceName.toLatin1().constData(), &d->m_saneHandle);
+    status = KSaneHandlePool::getInstance()->open(deviceName, &d->m_saneHandle, descriptors);
 
     bool password_dialog_ok = true;
 
@@ -379,7 +392,7 @@ bool KSaneWidget::openDevice(const QString &deviceName)
         // add/update the device user-name and password for authentication
         d->m_auth->setDeviceAuth(d->m_devName, dlg->username(), dlg->password());
 
-        status = sane_open(deviceName.toLatin1().constData(), &d->m_saneHandle);
+        status = KSaneHandlePool::getInstance()->open(deviceName, &d->m_saneHandle, descriptors);
 
 #ifdef HAVE_KF5WALLET
         // store password in wallet on successful authentication
@@ -413,25 +426,32 @@ bool KSaneWidget::openDevice(const QString &deviceName)
         }
     }
 
-    // Read the options (start with option 0 the number of parameters)
-    optDesc = sane_get_option_descriptor(d->m_saneHandle, 0);
-    if (optDesc == nullptr) {
-        d->m_auth->clearDeviceAuth(d->m_devName);
-        d->m_devName.clear();
-        return false;
-    }
-    QVarLengthArray<char> data(optDesc->size);
-    status = sane_control_option(d->m_saneHandle, 0, SANE_ACTION_GET_VALUE, data.data(), &res);
-    if (status != SANE_STATUS_GOOD) {
-        d->m_auth->clearDeviceAuth(d->m_devName);
-        d->m_devName.clear();
-        return false;
+    if (descriptors.isEmpty()) {
+        // Read the options (start with option 0 the number of parameters)
+        optDesc = sane_get_option_descriptor(d->m_saneHandle, 0);
+        if (optDesc == nullptr) {
+            d->m_auth->clearDeviceAuth(d->m_devName);
+            d->m_devName.clear();
+            return false;
+        }
+        QVarLengthArray<char> data(optDesc->size);
+        status = sane_control_option(d->m_saneHandle, 0, SANE_ACTION_GET_VALUE, data.data(), &res);
+        if (status != SANE_STATUS_GOOD) {
+            d->m_auth->clearDeviceAuth(d->m_devName);
+            d->m_devName.clear();
+            return false;
+        }
+        numSaneOptions = *reinterpret_cast<SANE_Word *>(data.data());
+        for (i = 0; i < numSaneOptions; ++i) {
+            descriptors.append(sane_get_option_descriptor(d->m_saneHandle, i));
+        }
     }
-    numSaneOptions = *reinterpret_cast<SANE_Word *>(data.data());
+    // a pooled handle comes with the descriptors of its options
+    numSaneOptions = descriptors.size();
 
     // read the rest of the options
     for (i = 1; i < numSaneOptions; ++i) {
-        switch (KSaneOption::optionType(sane_get_option_descriptor(d->m_saneHandle, i))) {
+        switch (KSaneOption::optionType(descriptors.at(i))) {
         case KSaneOption::TYPE_DETECT_FAIL:
             d->m_optList.append(new KSaneOption(d->m_saneHandle, i));
             break;
@@ -459,6 +479,16 @@ bool KSaneWidget::openDevice(const QString &deviceName)
         }
     }
 
+    d->rebuildOptionHash();
+
+    // The option worker executes the option I/O initiated by the widgets
+    // it runs before any job can be queued
+    d->m_optWorker = new KSaneOptionWorker(d->m_saneHandle, d);
+    d->m_optWorker->start();
+    for (i = 0; i < d->m_optList.size(); ++i) {
+        d->m_optList.at(i)->setWorker(d->m_optWorker);
+    }
+
     // do the connections of the option parameters
     for (i = 1; i < d->m_optList.size(); ++i) {
         //qDebug() << d->m_optList.at(i)->name();
@@ -476,18 +506,19 @@ bool KSaneWidget::openDevice(const QString &deviceName)
         }
     }
 
-    // start polling the poll options
-    if (d->m_pollList.size() > 0) {
-        d->m_optionPollTmr.start();
-    }
+    // poll the read-only options in a separate thread
+    d->m_optPoller = new KSaneOptionPoller(d->m_saneHandle, d->m_optWorker->deviceMutex(), d);
+    d->m_optPoller->setInterval(d->m_pollMinInterval, d->m_pollMaxInterval);
+    // the scan button starts the scan without a detour through the event loop
+    connect(d->m_optPoller, SIGNAL(scanButtonPressed()), d, SLOT(startButtonScan()), Qt::DirectConnection);
+    d->m_optPoller->start();
 
     // Create the preview thread
     d->m_previewThread = new KSanePreviewThread(d->m_saneHandle, &d->m_previewImg);
     connect(d->m_previewThread, SIGNAL(finished()), d, SLOT(previewScanDone()));
 
     // Create the read thread
-    d->m_scanThread = new KSaneScanThread(d->m_saneHandle, &d->m_scanData);
-    connect(d->m_scanThread, SIGNAL(finished()), d, SLOT(oneFinalScanDone()));
+    d->m_session->createThread(d->m_saneHandle, &d->m_scanData);
 
     // Create the options interface
     d->createOptInterface();
@@ -505,6 +536,9 @@ bool KSaneWidget::openDevice(const QString &deviceName)
     // having to scan a preview.
     d->updatePreviewSize();
     QTimer::singleShot(1000, d->m_previewViewer, SLOT(zoom2Fit()));
+
+    d->updatePollList();
+    d->resolveScanButton();
     return true;
 }
 
@@ -514,10 +548,23 @@ bool KSaneWidget::closeDevice()
         return true;
     }
 
-    if (d->m_scanThread->isRunning()) {
-        d->m_scanThread->cancelScan();
-        d->m_closeDevicePending = true;
-        return false;
+    if (d->m_session->pipelineWait()) {
+        scanCancel();
+    }
+
+    if (d->m_session->isRunning()) {
+        if (!d->m_session->thread()->abandoned()) {
+            d->m_session->thread()->cancelScan();
+            d->m_closeDevicePending = true;
+            return false;
+        }
+        // the queued abandoned() can not be waited for, the caller may block the event loop
+        d->m_session->releaseThread();
+        d->m_updProgressTmr.stop();
+        d->setBusy(false);
+        d->m_scanOngoing = false;
+        d->m_scanClaim.storeRelease(0);
+        emit scanDone(KSaneWidget::ErrorStalled, KSaneWidgetPrivate::abandonedMessage());
     }
 
     if (d->m_previewThread->isRunning()) {
@@ -527,8 +574,20 @@ bool KSaneWidget::closeDevice()
     }
 
     d->m_auth->clearDeviceAuth(d->m_devName);
+    // no option I/O may run while the handle is closed
+    if (d->m_optPoller) {
+        d->m_optPoller->stop();
+    }
+    if (d->m_optWorker) {
+        d->m_optWorker->stop();
+    }
     // else
-    sane_close(d->m_saneHandle);
+    if (d->m_session->handleAbandoned()) {
+        // the backend still blocks in the abandoned scan thread
+        qDebug() << "The handle of" << d->m_devName << "is not closed";
+    } else {
+        KSaneHandlePool::getInstance()->release(d->m_devName, d->m_saneHandle);
+    }
     d->m_saneHandle = nullptr;
     d->clearDeviceOptions();
 
@@ -671,8 +730,15 @@ void KSaneWidget::startPreviewScan()
 
 void KSaneWidget::scanCancel()
 {
-    if (d->m_scanThread->isRunning()) {
-        d->m_scanThread->cancelScan();
+    if (d->m_session->cancelPipelineWait()) {
+        // the next page of the batch is not started yet
+        emit scanDone(KSaneWidget::NoError, QStringLiteral(""));
+        d->finishScan();
+        return;
+    }
+
+    if (d->m_session->isRunning()) {
+        d->m_session->thread()->cancelScan();
     }
 
     if (d->m_previewThread->isRunning()) {
@@ -693,6 +759,7 @@ void KSaneWidget::getOptVals(QMap <QString, QString> &opts)
 
     for (int i = 1; i < d->m_optList.size(); i++) {
         option = d->m_optList.at(i);
+        option->refreshValue();
         if (option->getValue(tmp)) {
             opts[option->name()] = tmp;
         }
@@ -706,6 +773,7 @@ bool KSaneWidget::getOptVal(const QString &optname, QString &value)
     KSaneOption *option;
 
     if ((option = d->getOption(optname)) != nullptr) {
+        option->refreshValue();
         return option->getValue(value);
     }
     // Special handling for non sane option
@@ -718,7 +786,13 @@ bool KSaneWidget::getOptVal(const QString &optname, QString &value)
 
 int KSaneWidget::setOptVals(const QMap <QString, QString> &opts)
 {
-    if (d->m_scanThread->isRunning() ||
+    QMap<QString, bool> results;
+    return setOptVals(opts, results);
+}
+
+int KSaneWidget::setOptVals(const QMap <QString, QString> &opts, QMap<QString, bool> &results)
+{
+    if (d->m_session->isRunning() ||
             d->m_previewThread->isRunning()) {
         return -1;
     }
@@ -726,35 +800,54 @@ int KSaneWidget::setOptVals(const QMap <QString, QString> &opts)
     QString tmp;
     int i;
     int ret = 0;
+    KSaneOption *option;
+    QList<KSaneOption *> ordered[6];
+    QList<KSaneOption *> failed;
 
+    results.clear();
+    QMap<QString, QString>::const_iterator it;
+    for (it = opts.constBegin(); it != opts.constEnd(); ++it) {
+        results[it.key()] = false;
+    }
+
+    // write the options that other options depend on first
     for (i = 0; i < d->m_optList.size(); i++) {
-        if (opts.contains(d->m_optList.at(i)->name())) {
-            tmp = opts[d->m_optList.at(i)->name()];
-            if (d->m_optList.at(i)->setValue(tmp) == false) {
-                ret++;
+        option = d->m_optList.at(i);
+        if (opts.contains(option->name())) {
+            ordered[d->writeOrder(option)].append(option);
+        }
+    }
+
+    // the reloads caused by the writes are done once in the end
+    d->beginOptionBatch();
+    for (int order = 0; order < 6; order++) {
+        for (i = 0; i < ordered[order].size(); i++) {
+            option = ordered[order].at(i);
+            // the setters compare with the last known value
+            option->refreshValue();
+            if (option->setValue(opts[option->name()])) {
+                results[option->name()] = true;
+            } else {
+                failed.append(option);
             }
         }
     }
-    if ((d->m_splitGamChB) &&
-            (d->m_optGamR) &&
-            (d->m_optGamG) &&
-            (d->m_optGamB)) {
-        // check if the current gamma values are identical. if they are identical,
-        // uncheck the "Separate color intensity tables" checkbox
-        QString redGamma;
-        QString greenGamma;
-        QString blueGamma;
-        d->m_optGamR->getValue(redGamma);
-        d->m_optGamG->getValue(greenGamma);
-        d->m_optGamB->getValue(blueGamma);
-        if ((redGamma == greenGamma) && (greenGamma == blueGamma)) {
-            d->m_splitGamChB->setChecked(false);
-            // set the values to the common gamma widget
-            d->m_commonGamma->setValues(redGamma);
+    d->commitOptionBatch();
+
+    // a write can fail because the option was not valid before the reload
+    d->beginOptionBatch();
+    for (i = 0; i < failed.size(); i++) {
+        option = failed.at(i);
+        option->refreshValue();
+        if (option->setValue(opts[option->name()])) {
+            results[option->name()] = true;
         } else {
-            d->m_splitGamChB->setChecked(true);
+            ret++;
         }
     }
+    d->commitOptionBatch();
+
+    d->updateGammaSplit();
 
     // special handling for non-sane option
     if (opts.contains(InvetColorsOption)) {
@@ -765,13 +858,14 @@ int KSaneWidget::setOptVals(const QMap <QString, QString> &opts)
         } else {
             d->m_invertColors->setChecked(false);
         }
+        results[InvetColorsOption] = true;
     }
     return ret;
 }
 
 bool KSaneWidget::setOptVal(const QString &option, const QString &value)
 {
-    if (d->m_scanThread->isRunning() ||
+    if (d->m_session->isRunning() ||
             d->m_previewThread->isRunning()) {
         return false;
     }
@@ -779,29 +873,12 @@ bool KSaneWidget::setOptVal(const QString &option, const QString &value)
     KSaneOption *opt;
 
     if ((opt = d->getOption(option)) != nullptr) {
+        opt->refreshValue();
         if (opt->setValue(value)) {
-            if ((d->m_splitGamChB) &&
-                    (d->m_optGamR) &&
-                    (d->m_optGamG) &&
-                    (d->m_optGamB) &&
-                    ((opt == d->m_optGamR) ||
-                     (opt == d->m_optGamG) ||
-                     (opt == d->m_optGamB))) {
-                // check if the current gamma values are identical. if they are identical,
-                // uncheck the "Separate color intensity tables" checkbox
-                QString redGamma;
-                QString greenGamma;
-                QString blueGamma;
-                d->m_optGamR->getValue(redGamma);
-                d->m_optGamG->getValue(greenGamma);
-                d->m_optGamB->getValue(blueGamma);
-                if ((redGamma == greenGamma) && (greenGamma == blueGamma)) {
-                    d->m_splitGamChB->setChecked(false);
-                    // set the values to the common gamma widget
-                    d->m_commonGamma->setValues(redGamma);
-                } else {
-                    d->m_splitGamChB->setChecked(true);
-                }
+            if ((opt == d->m_optGamR) ||
+                    (opt == d->m_optGamG) ||
+                    (opt == d->m_optGamB)) {
+                d->updateGammaSplit();
             }
             return true;
         }
@@ -821,6 +898,69 @@ bool KSaneWidget::setOptVal(const QString &option, const QString &value)
     return false;
 }
 
+int KSaneWidget::optionHandle(const QString &optname) const
+{
+    KSaneOption *option = d->getOption(optname);
+    if (option == nullptr) {
+        return -1;
+    }
+    return d->m_optList.indexOf(option);
+}
+
+bool KSaneWidget::getOptVal(int handle, QString &value)
+{
+    if ((handle < 0) || (handle >= d->m_optList.size())) {
+        return false;
+    }
+    d->m_optList.at(handle)->refreshValue();
+    return d->m_optList.at(handle)->getValue(value);
+}
+
+bool KSaneWidget::getOptVal(int handle, float &value)
+{
+    if ((handle < 0) || (handle >= d->m_optList.size())) {
+        return false;
+    }
+    d->m_optList.at(handle)->refreshValue();
+    return d->m_optList.at(handle)->getValue(value);
+}
+
+bool KSaneWidget::setOptVal(int handle, const QString &value)
+{
+    if (d->m_session->isRunning() ||
+            d->m_previewThread->isRunning()) {
+        return false;
+    }
+    if ((handle < 0) || (handle >= d->m_optList.size())) {
+        return false;
+    }
+
+    KSaneOption *opt = d->m_optList.at(handle);
+    opt->refreshValue();
+    if (!opt->setValue(value)) {
+        return false;
+    }
+    if ((opt == d->m_optGamR) ||
+            (opt == d->m_optGamG) ||
+            (opt == d->m_optGamB)) {
+        d->updateGammaSplit();
+    }
+    return true;
+}
+
+bool KSaneWidget::setOptVal(int handle, float value)
+{
+    if (d->m_session->isRunning() ||
+            d->m_previewThread->isRunning()) {
+        return false;
+    }
+    if ((handle < 0) || (handle >= d->m_optList.size())) {
+        return false;
+    }
+    d->m_optList.at(handle)->refreshValue();
+    return d->m_optList.at(handle)->setValue(value);
+}
+
 void KSaneWidget::setScanButtonText(const QString &scanLabel)
 {
     if (d->m_scanBtn == nullptr) {
@@ -844,6 +984,16 @@ void KSaneWidget::enableAutoSelect(bool enable)
     d->m_autoSelect = enable;
 }
 
+void KSaneWidget::enableSinglePassSelections(bool enable)
+{
+    d->m_singlePassSel = enable;
+}
+
+int KSaneWidget::currentSelectionIndex() const
+{
+    return d->m_selIndex;
+}
+
 float KSaneWidget::currentDPI()
 {
     if (d->m_optRes) {
@@ -918,4 +1068,72 @@ void KSaneWidget::setScanButtonHidden(bool hidden)
     d->m_scanBtn->setHidden(hidden);
 }
 
+void KSaneWidget::setPollInterval(int minMsec, int maxMsec)
+{
+    d->m_pollMinInterval = qMax(1, minMsec);
+    d->m_pollMaxInterval = qMax(d->m_pollMinInterval, maxMsec);
+    if (d->m_optPoller) {
+        d->m_optPoller->setInterval(d->m_pollMinInterval, d->m_pollMaxInterval);
+    }
+}
+
+void KSaneWidget::setScanStallTimeout(int stallMsec, int escalationMsec)
+{
+    d->m_session->setStallTimeout(stallMsec, escalationMsec);
+}
+
+KSanePipeline *KSaneWidget::pipeline() const
+{
+    return d->m_pipeline;
+}
+
+bool KSaneWidget::setScanOnButton(const QString &optionName)
+{
+    d->m_scanButtonName = optionName;
+    if (!d->m_saneHandle) {
+        return optionName.isEmpty();
+    }
+    return (d->resolveScanButton() != nullptr) || optionName.isEmpty();
+}
+
+int KSaneWidget::buttonScanLatency() const
+{
+    return d->m_buttonScanLatency;
+}
+
+int KSaneWidget::elidedOptionWrites()
+{
+    return KSaneOption::elidedWrites();
+}
+
+void KSaneWidget::connectNotify(const QMetaMethod &signal)
+{
+    if (signal == QMetaMethod::fromSignal(&KSaneWidget::buttonPressed)) {
+        d->m_buttonListeners = true;
+        QMetaObject::invokeMethod(d, "updatePollList", Qt::QueuedConnection);
+    }
+    QWidget::connectNotify(signal);
+}
+
+void KSaneWidget::disconnectNotify(const QMetaMethod &signal)
+{
+    if (signal == QMetaMethod::fromSignal(&KSaneWidget::buttonPressed)) {
+        d->m_buttonListeners = isSignalConnected(QMetaMethod::fromSignal(&KSaneWidget::buttonPressed));
+        QMetaObject::invokeMethod(d, "updatePollList", Qt::QueuedConnection);
+    }
+    QWidget::disconnectNotify(signal);
+}
+
+void KSaneWidget::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    d->updatePollList();
+}
+
+void KSaneWidget::hideEvent(QHideEvent *event)
+{
+    QWidget::hideEvent(event);
+    d->updatePollList();
+}
+
 }  // NameSpace KSaneIface
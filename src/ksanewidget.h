@@ -39,6 +39,7 @@ namespace KSaneIface
 {
 
 class KSaneWidgetPrivate;
+class KSanePipeline;
 
 /**
  * This class provides the widget containing the scan options and the preview.
@@ -73,7 +74,9 @@ public:
                              * returned data. Scanning without segmentation should work.
                              * @note segmentation is not implemented yet.*/
         ErrorGeneral,        /**< The error string should contain an error message. */
-        Information          /**< There is some information to the user. */
+        Information,         /**< There is some information to the user. */
+        ErrorStalled         /**< The scanner stopped sending data and the scan was cancelled
+                              * (see setScanStallTimeout()). */
     } ScanStatus;
 
     struct DeviceInfo {
@@ -90,6 +93,20 @@ public:
     /** Standard destructor */
     ~KSaneWidget();
 
+    /** Enumerate the devices in a short-lived helper process that is killed after
+     * timeoutMsec, so that a backend that hangs can not block the device list.
+     * The devices that were found before the timeout are still listed.
+     * The helper is used by default (30 s timeout) when it is installed, because
+     * sane_get_devices() in this process blocks the opening of devices until it returns.
+     * @param timeoutMsec is the timeout or 0 to enumerate the devices in this process. */
+    static void setDeviceDiscoveryTimeout(int timeoutMsec);
+
+    /** Keep a closed device open for idleMsec, so that opening it again is fast. Many
+     * backends upload firmware and calibrate the device in sane_open(). The device stays
+     * busy for other processes while it is kept open.
+     * @param idleMsec is the idle time or 0 to close the devices right away (default). */
+    static void setDeviceIdleTimeout(int idleMsec);
+
     /** This helper method displays a dialog for selecting a scanner. The libsane
      * device name of the selected scanner device is returned. */
     QString selectDevice(QWidget *parent = nullptr);
@@ -184,6 +201,15 @@ public:
     * @return the resolution used for scanning or 0.0 on failure. */
     float currentDPI();
 
+    /** This method returns the index of the selection the acquired image belongs to.
+    * The saved selections have the indices 0 -> n-1 and the active selection n.
+    * The selections are not scanned in index order, but in the order that
+    * minimizes the scan head movement.
+    * @note This function should be called from the slot connected
+    * to the imageReady signal. The connection should not be queued.
+    * @return the index of the selection. */
+    int currentSelectionIndex() const;
+
     /** This method returns the scan area's width in mm
     * @return Width of the scannable area in mm */
     float scanAreaWidth();
@@ -215,6 +241,17 @@ public:
      * or -1 if scanning is in progress. */
     int setOptVals(const QMap <QString, QString> &opts);
 
+    /** This method can be used to write many parameter values at once.
+     * The parameters are written in dependency order: source, mode, depth,
+     * resolution, the other parameters and last the scan area. The option
+     * reloads caused by the writes are done once after all the writes, and
+     * the writes that failed are tried again after the reload.
+     * @param opts is a QMap with the parameter names and values.
+     * @param results returns for every parameter in opts if it was written successfully.
+     * @return This function returns the number of unsuccessful writes
+     * or -1 if scanning is in progress. */
+    int setOptVals(const QMap <QString, QString> &opts, QMap<QString, bool> &results);
+
     /** This function reads one parameter value into a string.
      * @param optname is the name of the parameter to read.
      * @param value is the string representation of the value.
@@ -228,6 +265,39 @@ public:
      * false if it was unsuccessful or scanning is in progress. */
     bool setOptVal(const QString &optname, const QString &value);
 
+    /** This function returns a handle for fast repeated access to one parameter.
+     * Accessing a parameter with the handle needs no name lookup or string allocation.
+     * @note The handle is valid until the device is closed.
+     * @param optname is the name of the parameter.
+     * @return the handle or -1 if there is no such parameter. */
+    int optionHandle(const QString &optname) const;
+
+    /** This function reads one parameter value into a string.
+     * @param handle is the handle returned by optionHandle().
+     * @param value is the string representation of the value.
+     * @return this function returns true if the read was successful. */
+    bool getOptVal(int handle, QString &value);
+
+    /** This function reads one numeric parameter value.
+     * @param handle is the handle returned by optionHandle().
+     * @param value is the value of the parameter.
+     * @return this function returns true if the read was successful. */
+    bool getOptVal(int handle, float &value);
+
+    /** This function writes one parameter value from a string.
+     * @param handle is the handle returned by optionHandle().
+     * @param value is the string representation of the value.
+     * @return this function returns true if the write was successful and
+     * false if it was unsuccessful or scanning is in progress. */
+    bool setOptVal(int handle, const QString &value);
+
+    /** This function writes one numeric parameter value.
+     * @param handle is the handle returned by optionHandle().
+     * @param value is the new value of the parameter.
+     * @return this function returns true if the write was successful and
+     * false if it was unsuccessful or scanning is in progress. */
+    bool setOptVal(int handle, float value);
+
     /** This function sets the label on the final scan button
     * @param scanLabel is the new label for the button. */
     void setScanButtonText(const QString &scanLabel);
@@ -241,6 +311,59 @@ public:
     * @param enable specifies if the auto selection should be turned on or off. */
     void enableAutoSelect(bool enable);
 
+    /** This function can be used to scan all selections in one pass.
+    * The bounding box of the selections is scanned once and the selections are
+    * cropped from it. One imageReady signal is emitted for every selection.
+    * This saves a carriage pass and lamp warm-up for each extra selection.
+    * The default state is disabled.
+    * @param enable specifies if the selections should be scanned in one pass. */
+    void enableSinglePassSelections(bool enable);
+
+    /** This function sets the limits of the adaptive polling of the read-only
+    * options like hardware buttons. The interval is doubled after every poll without
+    * a changed value, up to maxMsec, and reset to minMsec when a value changes.
+    * The options are only polled while buttonPressed() is connected or the option
+    * widget is visible. The default is 100 ms to 1000 ms.
+    * @param minMsec is the interval used after a change.
+    * @param maxMsec is the longest interval used while nothing changes. */
+    void setPollInterval(int minMsec, int maxMsec);
+
+    /** Cancel a scan when the scanner does not send data for stallMsec, so that an
+    * unattended batch scan does not hang forever. The scan is first cancelled after the
+    * running read, then sane_cancel() is called from a watchdog thread, and at last the
+    * scan is abandoned. Each step waits escalationMsec. The scan is finished with
+    * ErrorStalled. An abandoned device can not be used any more and must be closed.
+    * The time the scanner waits for the document or the scan button is not limited.
+    * @param stallMsec is the stall timeout or 0 to disable the watchdog (default).
+    * @param escalationMsec is the time between the cancel steps. */
+    void setScanStallTimeout(int stallMsec, int escalationMsec = 10000);
+
+    /** @return the pipeline that post-processes the scanned pages. Every page that is
+    * delivered with imageReady() is also queued in the pipeline, one page per selection.
+    * The row stages see the rows of the whole scanned area. When the pipeline is full, a
+    * batch scan waits with the next page until a page is processed. See KSaneImageStage
+    * for a stage that converts the pages to QImage. */
+    KSanePipeline *pipeline() const;
+
+    /** This function enables the scan on button mode. When the hardware button is
+    * pressed, the final scan is started directly from the poll thread with the
+    * current settings and selections, without waiting for the GUI event loop.
+    * The option is polled even if buttonPressed() is not connected. Use
+    * setPollInterval() to limit the time it takes to detect the press.
+    * The option name is remembered and used for devices opened later.
+    * @param optionName is the name of a hardware button option (see buttonPressed())
+    * or an empty string to disable the mode.
+    * @return true if the option is a hardware button of the current device. */
+    bool setScanOnButton(const QString &optionName);
+
+    /** @return the time in milliseconds from the detection of the last scan button press
+    * to the return of sane_start(), or -1 if no scan was started with the button. */
+    int buttonScanLatency() const;
+
+    /** @return the number of option writes in this process that were not sent to the
+    * device, because the device already had the value. */
+    static int elidedOptionWrites();
+
     /** This function is used to programatically collapse/restore the options.
     * @param collapse defines the state to set. */
     void setOptionsCollapsed(bool collapse);
@@ -264,7 +387,8 @@ public Q_SLOTS:
 
 Q_SIGNALS:
     /**
-     * This Signal is emitted when a final scan is ready.
+     * This Signal is emitted when a final scan is ready and was not dropped by a row
+     * stage of the pipeline().
      * @param data is the byte data containing the image.
      * @param width is the width of the image in pixels.
      * @param height is the height of the image in pixels.
@@ -306,6 +430,19 @@ Q_SIGNALS:
      */
     void availableDevices(const QList<KSaneWidget::DeviceInfo> &deviceList);
 
+    /**
+     * The device list is stored in a cache and availableDevices() is emitted with the
+     * cached list right away. The list is then checked in the background and this signal
+     * is emitted if devices were added or removed. It is also emitted when a USB
+     * scanner is plugged in or removed, together with availableDevices().
+     * When the devices are enumerated in the helper process, it is emitted for every
+     * new device as soon as the helper reports it.
+     * @param added are the devices that were not in the previous list.
+     * @param removed are the devices that are not available any more.
+     */
+    void devicesChanged(const QList<KSaneWidget::DeviceInfo> &added,
+                        const QList<KSaneWidget::DeviceInfo> &removed);
+
     /**
      * This Signal is emitted when a hardware button is pressed.
      * @param optionName is the untranslated technical name of the sane-option.
@@ -318,6 +455,12 @@ Q_SIGNALS:
      */
     void buttonPressed(const QString &optionName, const QString &optionLabel, bool pressed);
 
+protected:
+    void connectNotify(const QMetaMethod &signal) override;
+    void disconnectNotify(const QMetaMethod &signal) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
 private:
     KSaneWidgetPrivate *const d;
 };
@@ -28,6 +28,9 @@
  * ============================================================ */
 
 #include "ksanewidget_p.h"
+#include "ksaneoptcheckbox.h"
+#include "ksanecore.h"
+#include "ksanehandlepool.h"
 
 #include <QImage>
 #include <QScrollArea>
@@ -36,12 +39,12 @@
 #include <QLabel>
 #include <QPushButton>
 #include <QMessageBox>
+#include <QMutexLocker>
+#include <QElapsedTimer>
 #include <QDebug>
 
 #define SCALED_PREVIEW_MAX_SIDE 400
 
-static const int ActiveSelection = 100000;
-
 namespace KSaneIface
 {
 
@@ -61,8 +64,12 @@ KSaneWidgetPrivate::KSaneWidgetPrivate(KSaneWidget *parent):
     m_scanBtn       = nullptr;
     m_cancelBtn     = nullptr;
     m_previewViewer = nullptr;
+    m_batchDepth    = 0;
+    m_batchReloadPending = false;
     m_autoSelect    = true;
-    m_selIndex      = ActiveSelection;
+    m_singlePassSel = false;
+    m_selIndex      = 0;
+    m_jobIndex      = 0;
     m_warmingUp     = nullptr;
     m_progressBar   = nullptr;
 
@@ -71,31 +78,51 @@ KSaneWidgetPrivate::KSaneWidgetPrivate(KSaneWidget *parent):
 
     m_saneHandle    = nullptr;
     m_previewThread = nullptr;
-    m_scanThread    = nullptr;
+    m_optWorker     = nullptr;
+    m_optPoller     = nullptr;
+    m_pollMinInterval = 100;
+    m_pollMaxInterval = 1000;
+    m_buttonListeners = false;
+    m_scanButtonOpt = nullptr;
+    m_buttonScanArmed = false;
+    m_buttonScanLatency = -1;
 
     m_splitGamChB   = nullptr;
     m_commonGamma   = nullptr;
+    m_softGamma     = nullptr;
     m_previewDPI    = 0;
     m_invertColors  = nullptr;
 
     m_previewWidth  = 0;
     m_previewHeight = 0;
 
+    m_pipeline = new KSanePipeline(this);
+    m_session = new KSaneScanSession(m_pipeline, this);
+    m_session->setGammaStage(&m_gammaStage);
+    connect(m_session, SIGNAL(pageDone()), this, SLOT(oneFinalScanDone()));
+    connect(m_session, SIGNAL(abandoned()), this, SLOT(scanAbandoned()));
+    connect(m_session, SIGNAL(nextPage()), this, SLOT(startNextPage()));
+
     clearDeviceOptions();
 
     m_findDevThread = FindSaneDevicesThread::getInstance();
     connect(m_findDevThread, SIGNAL(finished()), this, SLOT(devListUpdated()));
     connect(m_findDevThread, SIGNAL(finished()), this, SLOT(signalDevListUpdate()));
+    connect(m_findDevThread, SIGNAL(finished()), this, SLOT(signalDevicesChanged()));
+    connect(m_findDevThread, SIGNAL(listChanged()), this, SLOT(signalDevListUpdate()));
+    connect(m_findDevThread, SIGNAL(listChanged()), this, SLOT(signalDevicesChanged()));
+    connect(m_findDevThread, SIGNAL(deviceFound(KSaneIface::KSaneWidget::DeviceInfo)),
+            this, SLOT(signalDeviceFound(KSaneIface::KSaneWidget::DeviceInfo)));
 
     m_auth = KSaneAuth::getInstance();
-    m_optionPollTmr.setInterval(100);
-    connect(&m_optionPollTmr, SIGNAL(timeout()), this, SLOT(pollPollOptions()));
 }
 
 void KSaneWidgetPrivate::clearDeviceOptions()
 {
     m_optSource     = nullptr;
     m_colorOpts     = nullptr;
+    m_gammaFrame    = nullptr;
+    m_otherOptsBuilt = false;
     m_optNegative   = nullptr;
     m_optFilmType   = nullptr;
     m_optMode       = nullptr;
@@ -110,17 +137,33 @@ void KSaneWidgetPrivate::clearDeviceOptions()
     m_optGamR       = nullptr;
     m_optGamG       = nullptr;
     m_optGamB       = nullptr;
+    m_softGamma     = nullptr;
+    m_gammaStage.setValues(0, 0, 100);
     m_optPreview    = nullptr;
     m_optWaitForBtn = nullptr;
     m_scanOngoing   = false;
     m_closeDevicePending = false;
 
+    // stop the option I/O before the options are deleted. Undelivered results are dropped.
+    delete m_optPoller;
+    m_optPoller = nullptr;
+    delete m_optWorker;
+    m_optWorker = nullptr;
+
+    m_scanButtonOpt = nullptr;
+    m_buttonScanMutex.lock();
+    m_buttonScanArmed = false;
+    m_buttonScanWrites.clear();
+    m_buttonScanMutex.unlock();
+    m_scanClaim.storeRelease(0);
+
     // delete all the options in the list.
     while (!m_optList.isEmpty()) {
         delete m_optList.takeFirst();
     }
+    m_optHash.clear();
+    m_batchReloads.clear();
     m_pollList.clear();
-    m_optionPollTmr.stop();
 
     // remove the remaining layouts/widgets and read thread
     delete m_basicOptsTab;
@@ -132,8 +175,7 @@ void KSaneWidgetPrivate::clearDeviceOptions()
     delete m_previewThread;
     m_previewThread = nullptr;
 
-    delete m_scanThread;
-    m_scanThread = nullptr;
+    m_session->clear();
 
     m_devName.clear();
 }
@@ -162,67 +204,65 @@ void KSaneWidgetPrivate::signalDevListUpdate()
     emit(q->availableDevices(m_findDevThread->devicesList()));
 }
 
-KSaneWidget::ImageFormat KSaneWidgetPrivate::getImgFormat(SANE_Parameters &params)
+void KSaneWidgetPrivate::signalDevicesChanged()
 {
-    switch (params.format) {
-    case SANE_FRAME_GRAY:
-        switch (params.depth) {
-        case 1:
-            return KSaneWidget::FormatBlackWhite;
-        case 8:
-            return KSaneWidget::FormatGrayScale8;
-        case 16:
-            return KSaneWidget::FormatGrayScale16;
-        default:
-            return KSaneWidget::FormatNone;
-        }
-    case SANE_FRAME_RGB:
-    case SANE_FRAME_RED:
-    case SANE_FRAME_GREEN:
-    case SANE_FRAME_BLUE:
-        switch (params.depth) {
-        case 8:
-            return KSaneWidget::FormatRGB_8_C;
-        case 16:
-            return KSaneWidget::FormatRGB_16_C;
-        default:
-            return KSaneWidget::FormatNone;
-        }
+    QList<KSaneWidget::DeviceInfo> added;
+    QList<KSaneWidget::DeviceInfo> removed;
+    m_findDevThread->lastChanges(added, removed);
+    if (!added.isEmpty() || !removed.isEmpty()) {
+        emit(q->devicesChanged(added, removed));
     }
-    return KSaneWidget::FormatNone;
 }
 
-int KSaneWidgetPrivate::getBytesPerLines(SANE_Parameters &params)
+void KSaneWidgetPrivate::signalDeviceFound(const KSaneWidget::DeviceInfo &device)
 {
-    switch (getImgFormat(params)) {
-    case KSaneWidget::FormatBlackWhite:
-    case KSaneWidget::FormatGrayScale8:
-    case KSaneWidget::FormatGrayScale16:
-        return params.bytes_per_line;
-
-    case KSaneWidget::FormatRGB_8_C:
-        return params.pixels_per_line * 3;
-
-    case KSaneWidget::FormatRGB_16_C:
-        return params.pixels_per_line * 6;
-
-    case KSaneWidget::FormatNone:
-    case KSaneWidget::FormatBMP: // to remove warning (BMP is omly valid in the twain wrapper)
-        return 0;
-    }
-    return 0;
+    QList<KSaneWidget::DeviceInfo> added;
+    added << device;
+    devListUpdated();
+    emit(q->availableDevices(m_findDevThread->devicesList()));
+    emit(q->devicesChanged(added, QList<KSaneWidget::DeviceInfo>()));
 }
 
 KSaneOption *KSaneWidgetPrivate::getOption(const QString &name)
+{
+    return m_optHash.value(name, nullptr);
+}
+
+void KSaneWidgetPrivate::rebuildOptionHash()
 {
     int i;
+    m_optHash.clear();
     for (i = 0; i < m_optList.size(); ++i) {
-        KSaneOption * option = m_optList.at(i);
-        if (option->name() == name) {
-            return option;
+        KSaneOption *option = m_optList.at(i);
+        // the first option with a name wins like in the old linear search
+        if (!m_optHash.contains(option->name())) {
+            m_optHash.insert(option->name(), option);
+        }
+    }
+}
+
+void KSaneWidgetPrivate::updateGammaSplit()
+{
+    if ((m_splitGamChB) &&
+            (m_optGamR) &&
+            (m_optGamG) &&
+            (m_optGamB)) {
+        // check if the current gamma values are identical. if they are identical,
+        // uncheck the "Separate color intensity tables" checkbox
+        QString redGamma;
+        QString greenGamma;
+        QString blueGamma;
+        m_optGamR->getValue(redGamma);
+        m_optGamG->getValue(greenGamma);
+        m_optGamB->getValue(blueGamma);
+        if ((redGamma == greenGamma) && (greenGamma == blueGamma)) {
+            m_splitGamChB->setChecked(false);
+            // set the values to the common gamma widget
+            m_commonGamma->setValues(redGamma);
+        } else {
+            m_splitGamChB->setChecked(true);
         }
     }
-    return nullptr;
 }
 
 void KSaneWidgetPrivate::createOptInterface()
@@ -333,46 +373,47 @@ void KSaneWidgetPrivate::createOptInterface()
     }
 
     // Add gamma tables to the color "frame"
-    QWidget *gamma_frm = new QWidget(m_colorOpts);
-    color_lay->addWidget(gamma_frm);
-    QVBoxLayout *gam_frm_l = new QVBoxLayout(gamma_frm);
+    m_gammaFrame = new QWidget(m_colorOpts);
+    color_lay->addWidget(m_gammaFrame);
+    QVBoxLayout *gam_frm_l = new QVBoxLayout(m_gammaFrame);
     gam_frm_l->setContentsMargins(0, 0, 0, 0);
 
-    if ((option = getOption(QStringLiteral(SANE_NAME_GAMMA_VECTOR_R))) != nullptr) {
-        m_optGamR = option;
-        option->createWidget(gamma_frm);
-        gam_frm_l->addWidget(option->widget());
-    }
-    if ((option = getOption(QStringLiteral(SANE_NAME_GAMMA_VECTOR_G))) != nullptr) {
-        m_optGamG = option;
-        option->createWidget(gamma_frm);
-        gam_frm_l->addWidget(option->widget());
-    }
-    if ((option = getOption(QStringLiteral(SANE_NAME_GAMMA_VECTOR_B))) != nullptr) {
-        m_optGamB = option;
-        option->createWidget(gamma_frm);
-        gam_frm_l->addWidget(option->widget());
-    }
+    m_optGamR = getOption(QStringLiteral(SANE_NAME_GAMMA_VECTOR_R));
+    m_optGamG = getOption(QStringLiteral(SANE_NAME_GAMMA_VECTOR_G));
+    m_optGamB = getOption(QStringLiteral(SANE_NAME_GAMMA_VECTOR_B));
 
     if ((m_optGamR != nullptr) && (m_optGamG != nullptr) && (m_optGamB != nullptr)) {
-        LabeledGamma *gamma = reinterpret_cast<LabeledGamma *>(m_optGamR->widget());
-        m_commonGamma = new LabeledGamma(m_colorOpts, i18n(SANE_TITLE_GAMMA_VECTOR), gamma->size(), gamma->maxValue());
+        // The separate tables are only created when they are shown the first time
+        float maxValue = 0;
+        m_optGamR->getMaxValue(maxValue);
+        m_commonGamma = new LabeledGamma(m_colorOpts, i18n(SANE_TITLE_GAMMA_VECTOR),
+                                         m_optGamR->valueSize() / sizeof(SANE_Word), (int)maxValue);
 
         color_lay->addWidget(m_commonGamma);
 
         m_commonGamma->setToolTip(i18n(SANE_DESC_GAMMA_VECTOR));
 
-        connect(m_commonGamma, SIGNAL(gammaChanged(int,int,int)), m_optGamR->widget(), SLOT(setValues(int,int,int)));
-        connect(m_commonGamma, SIGNAL(gammaChanged(int,int,int)), m_optGamG->widget(), SLOT(setValues(int,int,int)));
-        connect(m_commonGamma, SIGNAL(gammaChanged(int,int,int)), m_optGamB->widget(), SLOT(setValues(int,int,int)));
+        connect(m_commonGamma, SIGNAL(gammaChanged(int,int,int)), m_optGamR, SLOT(setGammaValues(int,int,int)));
+        connect(m_commonGamma, SIGNAL(gammaChanged(int,int,int)), m_optGamG, SLOT(setGammaValues(int,int,int)));
+        connect(m_commonGamma, SIGNAL(gammaChanged(int,int,int)), m_optGamB, SLOT(setGammaValues(int,int,int)));
 
         m_splitGamChB = new LabeledCheckbox(m_colorOpts, i18n("Separate color intensity tables"));
         color_lay->addWidget(m_splitGamChB);
 
-        connect(m_splitGamChB, SIGNAL(toggled(bool)), gamma_frm, SLOT(setVisible(bool)));
+        connect(m_splitGamChB, SIGNAL(toggled(bool)), this, SLOT(createGammaWidgets()));
+        connect(m_splitGamChB, SIGNAL(toggled(bool)), m_gammaFrame, SLOT(setVisible(bool)));
         connect(m_splitGamChB, SIGNAL(toggled(bool)), m_commonGamma, SLOT(setHidden(bool)));
 
-        gamma_frm->hide();
+        m_gammaFrame->hide();
+    } else if ((m_optGamR == nullptr) && (m_optGamG == nullptr) && (m_optGamB == nullptr) &&
+               (getOption(QStringLiteral(SANE_NAME_GAMMA_VECTOR)) == nullptr)) {
+        // The curve is applied to the scanned rows instead
+        m_softGamma = new LabeledGamma(m_colorOpts, i18n("Color correction"), 256, 255);
+        color_lay->addWidget(m_softGamma);
+        m_softGamma->setToolTip(i18n("The scanner has no intensity tables, so the curve is applied to the scanned image."));
+        connect(m_softGamma, SIGNAL(gammaChanged(int,int,int)), this, SLOT(setSoftwareGamma(int,int,int)));
+    } else {
+        createGammaWidgets();
     }
 
     if ((option = getOption(QStringLiteral(SANE_NAME_BLACK_LEVEL))) != nullptr) {
@@ -388,33 +429,17 @@ void KSaneWidgetPrivate::createOptInterface()
     color_lay->addWidget(m_invertColors);
     m_invertColors->setChecked(false);
     connect(m_invertColors, SIGNAL(toggled(bool)), this, SLOT(invertPreview()));
+    connect(m_invertColors, SIGNAL(toggled(bool)), this, SLOT(armButtonScan()));
 
     // add a stretch to the end to keep the parameters at the top
     basic_layout->addStretch();
 
-    // Remaining (un known) options go to the "Other Options"
+    // Remaining (un known) options go to the "Other Options". The widgets are
+    // created when the tab is shown the first time in createOtherOptions().
     m_otherOptsTab = new QWidget;
     m_otherScrollA->setWidget(m_otherOptsTab);
 
-    QVBoxLayout *other_layout = new QVBoxLayout(m_otherOptsTab);
-
-    // add the remaining parameters
-    for (int i = 0; i < m_optList.size(); ++i) {
-        KSaneOption *option = m_optList.at(i);
-        if ((option->widget() == nullptr) &&
-                (option->name() != QStringLiteral(SANE_NAME_SCAN_TL_X)) &&
-                (option->name() != QStringLiteral(SANE_NAME_SCAN_TL_Y)) &&
-                (option->name() != QStringLiteral(SANE_NAME_SCAN_BR_X)) &&
-                (option->name() != QStringLiteral(SANE_NAME_SCAN_BR_Y)) &&
-                (option->name() != QStringLiteral(SANE_NAME_PREVIEW)) &&
-                (option->hasGui())) {
-            option->createWidget(m_otherOptsTab);
-            other_layout->addWidget(option->widget());
-        }
-    }
-
-    // add a stretch to the end to keep the parameters at the top
-    other_layout->addStretch();
+    new QVBoxLayout(m_otherOptsTab);
 
     // calculate label widths
     int labelWidth = 0;
@@ -454,8 +479,67 @@ void KSaneWidgetPrivate::createOptInterface()
             }
         }
     }
-    // Other Options
-    labelWidth = 0;
+    // ensure that we do not get a scrollbar at the bottom of the option of the options
+    int min_width = m_basicOptsTab->sizeHint().width();
+    if (min_width < m_otherOptsTab->sizeHint().width()) {
+        min_width = m_otherOptsTab->sizeHint().width();
+    }
+
+    m_optsTabWidget->setMinimumWidth(min_width + m_basicScrollA->verticalScrollBar()->sizeHint().width() + 5);
+
+    // the other options tab can already be the current tab
+    createOtherOptions();
+}
+
+void KSaneWidgetPrivate::createGammaWidgets()
+{
+    if (m_gammaFrame == nullptr) {
+        return;
+    }
+
+    KSaneOption *gammaOpts[3] = { m_optGamR, m_optGamG, m_optGamB };
+    for (int i = 0; i < 3; ++i) {
+        if ((gammaOpts[i] != nullptr) && (gammaOpts[i]->widget() == nullptr)) {
+            gammaOpts[i]->createWidget(m_gammaFrame);
+            m_gammaFrame->layout()->addWidget(gammaOpts[i]->widget());
+        }
+    }
+}
+
+void KSaneWidgetPrivate::createOtherOptions()
+{
+    if ((m_otherOptsTab == nullptr) || m_otherOptsBuilt ||
+            (m_optsTabWidget->currentWidget() != m_otherScrollA)) {
+        return;
+    }
+    m_otherOptsBuilt = true;
+
+    QVBoxLayout *other_layout = qobject_cast<QVBoxLayout *>(m_otherOptsTab->layout());
+
+    // add the remaining parameters
+    for (int i = 0; i < m_optList.size(); ++i) {
+        KSaneOption *option = m_optList.at(i);
+        if ((option->widget() == nullptr) &&
+                (option->name() != QStringLiteral(SANE_NAME_SCAN_TL_X)) &&
+                (option->name() != QStringLiteral(SANE_NAME_SCAN_TL_Y)) &&
+                (option->name() != QStringLiteral(SANE_NAME_SCAN_BR_X)) &&
+                (option->name() != QStringLiteral(SANE_NAME_SCAN_BR_Y)) &&
+                (option->name() != QStringLiteral(SANE_NAME_PREVIEW)) &&
+                (option != m_optGamR) &&
+                (option != m_optGamG) &&
+                (option != m_optGamB) &&
+                (option->hasGui())) {
+            option->createWidget(m_otherOptsTab);
+            other_layout->addWidget(option->widget());
+        }
+    }
+
+    // add a stretch to the end to keep the parameters at the top
+    other_layout->addStretch();
+
+    // calculate label widths
+    int labelWidth = 0;
+    KSaneOptionWidget *tmpOption;
     for (int i = 0; i < other_layout->count(); ++i) {
         if (other_layout->itemAt(i) && other_layout->itemAt(i)->widget()) {
             tmpOption = qobject_cast<KSaneOptionWidget *>(other_layout->itemAt(i)->widget());
@@ -473,13 +557,9 @@ void KSaneWidgetPrivate::createOptInterface()
         }
     }
 
-    // ensure that we do not get a scrollbar at the bottom of the option of the options
-    int min_width = m_basicOptsTab->sizeHint().width();
-    if (min_width < m_otherOptsTab->sizeHint().width()) {
-        min_width = m_otherOptsTab->sizeHint().width();
-    }
-
-    m_optsTabWidget->setMinimumWidth(min_width + m_basicScrollA->verticalScrollBar()->sizeHint().width() + 5);
+    updateOptionLayout();
+    // the new widgets are shown by the layout in the next event loop round
+    QTimer::singleShot(0, this, SLOT(updatePollList()));
 }
 
 void KSaneWidgetPrivate::setDefaultValues()
@@ -510,12 +590,56 @@ void KSaneWidgetPrivate::scheduleValReload()
 void KSaneWidgetPrivate::optReload()
 {
     int i;
+    bool changed = false;
+    // without the written option all shown values are read again
+    KSaneOption *writer = qobject_cast<KSaneOption *>(sender());
 
+    // Only the options with a changed descriptor are read again and only the
+    // values that can have been changed by the write. Every read is a round trip
+    // to the device and the network backend is slow.
     for (i = 0; i < m_optList.size(); ++i) {
-        m_optList.at(i)->readOption();
-        // Also read the values
-        m_optList.at(i)->readValue();
+        // any value might have been changed by the device
+        m_optList.at(i)->invalidateValueCache();
+
+        bool readValue = (writer == nullptr) || (m_optList.at(i) == writer) ||
+                         valueMayDependOn(m_optList.at(i), writer);
+        if (m_optList.at(i)->descriptorChanged()) {
+            m_optList.at(i)->readOption();
+            readValue = true;
+            changed = true;
+        }
+        if (!readValue) {
+            continue;
+        }
+        if (m_batchDepth > 0) {
+            // the value is read when the batch is committed
+            if (!m_batchReloads.contains(m_optList.at(i))) {
+                m_batchReloads.append(m_optList.at(i));
+            }
+        } else if (needsValueRead(m_optList.at(i))) {
+            // Also read the values
+            m_optList.at(i)->readValueAsync();
+        }
+    }
+    if (changed) {
+        // the option names can change too
+        rebuildOptionHash();
     }
+
+    if (m_batchDepth > 0) {
+        m_batchReloadPending = true;
+        return;
+    }
+    if (changed) {
+        updateOptionLayout();
+    } else {
+        // the widgets are unchanged, but the scan area can have new limits
+        updatePreviewSize();
+    }
+}
+
+void KSaneWidgetPrivate::updateOptionLayout()
+{
     // Gamma table special case
     if (m_optGamR && m_optGamG && m_optGamB) {
         m_commonGamma->setHidden(m_optGamR->state() == KSaneOption::STATE_HIDDEN);
@@ -536,6 +660,78 @@ void KSaneWidgetPrivate::optReload()
     m_optsTabWidget->setMinimumWidth(min_width + m_basicScrollA->verticalScrollBar()->sizeHint().width() + 5);
 
     m_previewViewer->zoom2Fit();
+
+    // the visibility of the polled options can have changed
+    updatePollList();
+}
+
+void KSaneWidgetPrivate::beginOptionBatch()
+{
+    m_batchDepth++;
+}
+
+void KSaneWidgetPrivate::commitOptionBatch()
+{
+    int i;
+
+    if (m_batchDepth == 0) {
+        return;
+    }
+    m_batchDepth--;
+    if ((m_batchDepth > 0) || !m_batchReloadPending) {
+        return;
+    }
+
+    for (i = 0; i < m_batchReloads.size(); ++i) {
+        if (needsValueRead(m_batchReloads.at(i))) {
+            m_batchReloads.at(i)->readValueAsync();
+        }
+    }
+    m_batchReloads.clear();
+    m_batchReloadPending = false;
+    updateOptionLayout();
+}
+
+int KSaneWidgetPrivate::writeOrder(KSaneOption *option) const
+{
+    // The options that other options depend on are written first
+    if (option == m_optSource) {
+        return 0;
+    }
+    if (option == m_optMode) {
+        return 1;
+    }
+    if (option == m_optDepth) {
+        return 2;
+    }
+    if ((option == m_optRes) || (option == m_optResX) || (option == m_optResY)) {
+        return 3;
+    }
+    if ((option == m_optTlX) || (option == m_optTlY) || (option == m_optBrX) || (option == m_optBrY)) {
+        // the geometry limits can depend on all of the above
+        return 5;
+    }
+    return 4;
+}
+
+bool KSaneWidgetPrivate::valueMayDependOn(KSaneOption *option, KSaneOption *writer) const
+{
+    // The backends adjust the depth, the resolution and the scan area to the options
+    // that are written before them. Other values only change with their descriptor.
+    int order = writeOrder(option);
+    if ((order != 2) && (order != 3) && (order != 5)) {
+        return false;
+    }
+    return writeOrder(writer) < order;
+}
+
+bool KSaneWidgetPrivate::needsValueRead(KSaneOption *option) const
+{
+    // The values of the options without a widget are read on demand with
+    // KSaneOption::refreshValue(). The scan area is shown in the preview.
+    return (option->widget() != nullptr) ||
+           (option == m_optTlX) || (option == m_optTlY) ||
+           (option == m_optBrX) || (option == m_optBrY);
 }
 
 void KSaneWidgetPrivate::valReload()
@@ -544,7 +740,11 @@ void KSaneWidgetPrivate::valReload()
     QString tmp;
 
     for (i = 0; i < m_optList.size(); ++i) {
-        m_optList.at(i)->readValue();
+        if (needsValueRead(m_optList.at(i))) {
+            m_optList.at(i)->readValueAsync();
+        } else {
+            m_optList.at(i)->invalidateValueCache();
+        }
     }
 
 }
@@ -553,11 +753,7 @@ void KSaneWidgetPrivate::handleSelection(float tl_x, float tl_y, float br_x, flo
 {
 
     if ((m_optTlX == nullptr) || (m_optTlY == nullptr) || (m_optBrX == nullptr) || (m_optBrY == nullptr)) {
-        // clear the selection since we can not set one
-        m_previewViewer->setTLX(0);
-        m_previewViewer->setTLY(0);
-        m_previewViewer->setBRX(0);
-        m_previewViewer->setBRY(0);
+        // the selections are cropped from the whole scan area in startFinalScan()
         return;
     }
     float max_x, max_y;
@@ -585,7 +781,7 @@ void KSaneWidgetPrivate::setTLX(float ftlx)
     if (m_previewThread->isRunning()) {
         return;
     }
-    if (m_scanThread->isRunning()) {
+    if (m_session->isRunning()) {
         return;
     }
     if (m_scanOngoing) {
@@ -607,7 +803,7 @@ void KSaneWidgetPrivate::setTLY(float ftly)
     if (m_previewThread->isRunning()) {
         return;
     }
-    if (m_scanThread->isRunning()) {
+    if (m_session->isRunning()) {
         return;
     }
     if (m_scanOngoing) {
@@ -629,7 +825,7 @@ void KSaneWidgetPrivate::setBRX(float fbrx)
     if (m_previewThread->isRunning()) {
         return;
     }
-    if (m_scanThread->isRunning()) {
+    if (m_session->isRunning()) {
         return;
     }
     if (m_scanOngoing) {
@@ -651,7 +847,7 @@ void KSaneWidgetPrivate::setBRY(float fbry)
     if (m_previewThread->isRunning()) {
         return;
     }
-    if (m_scanThread->isRunning()) {
+    if (m_session->isRunning()) {
         return;
     }
     if (m_scanOngoing) {
@@ -726,11 +922,18 @@ void KSaneWidgetPrivate::updatePreviewSize()
 
 void KSaneWidgetPrivate::startPreviewScan()
 {
-    if (m_scanOngoing) {
+    if (m_scanOngoing || m_session->handleAbandoned()) {
+        return;
+    }
+    // the scan button can have started a scan that is not yet known here
+    if (!m_scanClaim.testAndSetOrdered(0, 1)) {
         return;
     }
     m_scanOngoing = true;
 
+    // the scan must start with the values the user has set
+    m_optWorker->flush();
+
     SANE_Status status;
     float max_x, max_y;
     float dpi;
@@ -763,10 +966,6 @@ void KSaneWidgetPrivate::startPreviewScan()
         m_optTlY->setValue(0);
         m_optBrX->setValue(max_x);
         m_optBrY->setValue(max_y);
-
-    } else {
-        // no use to try auto selections if you can not use them
-        m_autoSelect = false;
     }
 
     if (m_optRes != nullptr) {
@@ -842,7 +1041,14 @@ void KSaneWidgetPrivate::previewScanDone()
 
     if (m_closeDevicePending) {
         setBusy(false);
-        sane_close(m_saneHandle);
+        // no option I/O may run while the handle is closed
+        if (m_optPoller) {
+            m_optPoller->stop();
+        }
+        if (m_optWorker) {
+            m_optWorker->stop();
+        }
+        KSaneHandlePool::getInstance()->release(m_devName, m_saneHandle);
         m_saneHandle = nullptr;
         clearDeviceOptions();
         emit(q->scanDone(KSaneWidget::NoError, QStringLiteral("")));
@@ -878,6 +1084,8 @@ void KSaneWidgetPrivate::previewScanDone()
 
     setBusy(false);
     m_scanOngoing = false;
+    m_scanClaim.storeRelease(0);
+    armButtonScan();
     m_updProgressTmr.stop();
 
     emit(q->scanDone(KSaneWidget::NoError, QStringLiteral("")));
@@ -887,36 +1095,134 @@ void KSaneWidgetPrivate::previewScanDone()
 
 void KSaneWidgetPrivate::startFinalScan()
 {
-    if (m_scanOngoing) {
+    if (m_scanOngoing || (m_session->thread() == nullptr)) {
+        return;
+    }
+    // the scan button can have started a scan that is not yet known here
+    if (!m_scanClaim.testAndSetOrdered(0, 1)) {
         return;
     }
     m_scanOngoing = true;
     m_isPreview = false;
 
-    float x1 = 0, y1 = 0, x2 = 0, y2 = 0, max_x, max_y;
+    // the scan must start with the values the user has set
+    m_optWorker->flush();
 
+    planScanJobs();
+
+    setBusy(true);
+    m_session->thread()->setImageInverted(m_invertColors->isChecked());
+    startScanJob();
+}
+
+void KSaneWidgetPrivate::planScanJobs()
+{
+    float x1 = 0, y1 = 0, x2 = 0, y2 = 0;
+    QList<ScanJob> selections;
+
+    m_scanJobs.clear();
+    m_jobIndex = 0;
     m_selIndex = 0;
 
+    bool haveGeometry = (m_optTlX != nullptr) && (m_optTlY != nullptr) &&
+                        (m_optBrX != nullptr) && (m_optBrY != nullptr);
+
+    if (!haveGeometry && (m_previewViewer->selListSize() == 0)) {
+        // scan the whole area
+        ScanJob job;
+        job.area = QRectF(0, 0, 1, 1);
+        job.indices.append(0);
+        m_scanJobs.append(job);
+        return;
+    }
+
+    // read the selections from the viewer and sort them by the top edge,
+    // so that the scan head only needs to move forward between the passes
+    int count = qMax(m_previewViewer->selListSize(), 1);
+    for (int i = 0; i < count; i++) {
+        m_previewViewer->selectionAt(i, x1, y1, x2, y2);
+        ScanJob sel;
+        sel.area = QRectF(QPointF(x1, y1), QPointF(x2, y2));
+        sel.indices.append(i);
+        int pos = 0;
+        while ((pos < selections.size()) && (selections.at(pos).area.top() <= sel.area.top())) {
+            pos++;
+        }
+        selections.insert(pos, sel);
+    }
+
+    if (!haveGeometry) {
+        // The scan area can not be set, so the whole area is scanned once
+        // and all the selections are cropped from it.
+        ScanJob job;
+        job.area = QRectF(0, 0, 1, 1);
+        for (int i = 0; i < selections.size(); i++) {
+            job.regions.append(selections.at(i).area);
+            job.indices.append(selections.at(i).indices.first());
+        }
+        m_scanJobs.append(job);
+        return;
+    }
+
+    for (int i = 0; i < selections.size(); i++) {
+        const ScanJob &sel = selections.at(i);
+        // The head passes over a selection that starts before the previous one ends,
+        // so it is cheaper to crop both from one pass.
+        if (!m_scanJobs.isEmpty() &&
+                (m_singlePassSel || (sel.area.top() < m_scanJobs.last().area.bottom()))) {
+            ScanJob &job = m_scanJobs.last();
+            if (job.regions.isEmpty()) {
+                job.regions.append(job.area);
+            }
+            job.regions.append(sel.area);
+            job.indices.append(sel.indices.first());
+            job.area |= sel.area;
+        } else {
+            m_scanJobs.append(sel);
+        }
+    }
+
+    // the crop regions are relative to the scanned area
+    for (int i = 0; i < m_scanJobs.size(); i++) {
+        ScanJob &job = m_scanJobs[i];
+        if (job.regions.isEmpty()) {
+            continue;
+        }
+        if ((job.area.width() <= 0) || (job.area.height() <= 0)) {
+            // just precaution
+            job.regions.clear();
+            continue;
+        }
+        for (int j = 0; j < job.regions.size(); j++) {
+            job.regions[j] = QRectF((job.regions[j].left() - job.area.left()) / job.area.width(),
+                                    (job.regions[j].top() - job.area.top()) / job.area.height(),
+                                    job.regions[j].width() / job.area.width(),
+                                    job.regions[j].height() / job.area.height());
+        }
+    }
+}
+
+void KSaneWidgetPrivate::startScanJob()
+{
+    const ScanJob &job = m_scanJobs.at(m_jobIndex);
+
     if ((m_optTlX != nullptr) && (m_optTlY != nullptr) && (m_optBrX != nullptr) && (m_optBrY != nullptr)) {
+        float max_x, max_y;
+
         // get maximums
         m_optBrX->getMaxValue(max_x);
         m_optBrY->getMaxValue(max_y);
 
-        // read the selection from the viewer
-        m_previewViewer->selectionAt(m_selIndex, x1, y1, x2, y2);
-        m_previewViewer->setHighlightArea(x1, y1, x2, y2);
-        m_selIndex++;
-
-        // calculate the option values
-        x1 *= max_x; y1 *= max_y;
-        x2 *= max_x; y2 *= max_y;
+        // set the highlight
+        m_previewViewer->setHighlightArea(job.area.left(), job.area.top(), job.area.right(), job.area.bottom());
 
         // now set the selection
-        m_optTlX->setValue(x1);
-        m_optTlY->setValue(y1);
-        m_optBrX->setValue(x2);
-        m_optBrY->setValue(y2);
+        m_optTlX->setValue(job.area.left() * max_x);
+        m_optTlY->setValue(job.area.top() * max_y);
+        m_optBrX->setValue(job.area.right() * max_x);
+        m_optBrY->setValue(job.area.bottom() * max_y);
     }
+    m_selIndex = job.indices.first();
 
     // execute a pending value reload
     while (m_readValsTmr.isActive()) {
@@ -924,142 +1230,168 @@ void KSaneWidgetPrivate::startFinalScan()
         valReload();
     }
 
-    setBusy(true);
     m_updProgressTmr.start();
-    m_scanThread->setImageInverted(m_invertColors->isChecked());
-    m_scanThread->start();
+    m_session->thread()->setCropRegions(job.regions);
+    m_session->thread()->start();
 }
 
 void KSaneWidgetPrivate::oneFinalScanDone()
 {
+    KSaneScanThread *thread = m_session->thread();
     m_updProgressTmr.stop();
     updateProgress();
 
+    if (thread->startLatency() >= 0) {
+        m_buttonScanLatency = thread->startLatency();
+    }
+
     if (m_closeDevicePending) {
         setBusy(false);
-        sane_close(m_saneHandle);
+        // no option I/O may run while the handle is closed
+        if (m_optPoller) {
+            m_optPoller->stop();
+        }
+        if (m_optWorker) {
+            m_optWorker->stop();
+        }
+        KSaneHandlePool::getInstance()->release(m_devName, m_saneHandle);
         m_saneHandle = nullptr;
         clearDeviceOptions();
         return;
     }
 
-    if (m_scanThread->frameStatus() == KSaneScanThread::READ_READY) {
+    if (thread->frameStatus() == KSaneScanThread::READ_READY) {
         // scan finished OK
-        SANE_Parameters params = m_scanThread->saneParameters();
-        int lines = params.lines;
-        if (lines == -1) {
-            // this is probably a handscanner -> calculate the size from the read data
-            int bytesPerLine = qMax(getBytesPerLines(params), 1); // ensure no div by 0
-            lines = m_scanData.size() / bytesPerLine;
+        KSanePage page = KSaneScanSession::pageFromParameters(thread->saneParameters(), m_scanData.size());
+        page.dpi = (int)q->currentDPI();
+        if (thread->cropRegionCount() == 0) {
+            page.data = m_scanData;
+        }
+        m_pipeline->endRows(page);
+
+        if (page.dropped) {
+            m_pipeline->queuePage(page);
+        } else if (thread->cropRegionCount() > 0) {
+            // one scan pass for many selections
+            const ScanJob &job = m_scanJobs.at(m_jobIndex);
+            for (int i = 0; i < thread->cropRegionCount(); i++) {
+                QRect rect = thread->regionRect(i);
+                m_selIndex = job.indices.at(i);
+                emit(q->imageReady(thread->regionData(i),
+                                   rect.width(),
+                                   rect.height(),
+                                   thread->regionBytesPerLine(i),
+                                   page.format));
+
+                KSanePage regionPage = page;
+                regionPage.data   = thread->regionData(i);
+                regionPage.width  = rect.width();
+                regionPage.height = rect.height();
+                regionPage.bytesPerLine = thread->regionBytesPerLine(i);
+                m_pipeline->queuePage(regionPage);
+            }
+        } else {
+            emit(q->imageReady(m_scanData,
+                               page.width,
+                               page.height,
+                               page.bytesPerLine,
+                               page.format));
+            m_pipeline->queuePage(page);
         }
-        emit(q->imageReady(m_scanData,
-                           params.pixels_per_line,
-                           lines,
-                           getBytesPerLines(params),
-                           (int)getImgFormat(params)));
 
-        // now check if we should have automatic ADF batch scanning
+        // now check if we should have automatic ADF or "wait for button" batch scanning
+        QString source;
+        QString wait;
         if (m_optSource) {
-            QString source;
             m_optSource->getValue(source);
-
-            if (source.contains(QStringLiteral("Automatic Document Feeder")) ||
-                source.contains(QStringLiteral("ADF"))) {
-                // in batch mode only one area can be scanned per page
-                //qDebug() << "source == " << source;
-                m_updProgressTmr.start();
-                m_scanThread->start();
-                return;
-            }
         }
-
-        // Check if we have a "wait for button" batch scanning
-        if (m_optWaitForBtn) {
-            qDebug() << m_optWaitForBtn->name();
-            QString wait;
+        if (m_optWaitForBtn && !KSaneScanSession::isBatchScan(source, wait)) {
+            m_optWaitForBtn->refreshValue();
             m_optWaitForBtn->getValue(wait);
-
-            qDebug() << "wait ==" << wait;
-            if (wait == QStringLiteral("true")) {
-                // in batch mode only one area can be scanned per page
-                //qDebug() << "source == \"Automatic Document Feeder\"";
-                m_updProgressTmr.start();
-                m_scanThread->start();
-                return;
-            }
+        }
+        if (KSaneScanSession::isBatchScan(source, wait)) {
+            // in batch mode only one area can be scanned per page
+            m_session->requestNextPage();
+            return;
         }
 
         // not batch scan, call sane_cancel to be able to change parameters.
         sane_cancel(m_saneHandle);
 
-        //qDebug() << "index=" << m_selIndex << "size=" << m_previewViewer->selListSize();
-        // check if we have multiple selections.
-        if (m_previewViewer->selListSize() > m_selIndex) {
-            if ((m_optTlX != nullptr) && (m_optTlY != nullptr) && (m_optBrX != nullptr) && (m_optBrY != nullptr)) {
-                float x1 = 0, y1 = 0, x2 = 0, y2 = 0, max_x, max_y;
-
-                // get maximums
-                m_optBrX->getMaxValue(max_x);
-                m_optBrY->getMaxValue(max_y);
-
-                // read the selection from the viewer
-                m_previewViewer->selectionAt(m_selIndex, x1, y1, x2, y2);
-
-                // set the highlight
-                m_previewViewer->setHighlightArea(x1, y1, x2, y2);
-
-                // calculate the option values
-                x1 *= max_x; y1 *= max_y;
-                x2 *= max_x; y2 *= max_y;
-
-                // now set the selection
-                m_optTlX->setValue(x1);
-                m_optTlY->setValue(y1);
-                m_optBrX->setValue(x2);
-                m_optBrY->setValue(y2);
-                m_selIndex++;
-
-                // execute a pending value reload
-                while (m_readValsTmr.isActive()) {
-                    m_readValsTmr.stop();
-                    valReload();
-                }
-                m_updProgressTmr.start();
-                m_scanThread->start();
-                return;
-            }
+        // check if we have more selections to scan
+        m_jobIndex++;
+        if (m_jobIndex < m_scanJobs.size()) {
+            startScanJob();
+            return;
         }
         emit(q->scanDone(KSaneWidget::NoError, QStringLiteral("")));
+    } else if (thread->stalled()) {
+        const QString message = stalledMessage();
+        emit(q->scanDone(KSaneWidget::ErrorStalled, message));
+        alertUser(KSaneWidget::ErrorStalled, message);
     } else {
-        switch (m_scanThread->saneStatus()) {
-        case SANE_STATUS_GOOD:
-        case SANE_STATUS_CANCELLED:
-        case SANE_STATUS_EOF:
-            break;
-        case SANE_STATUS_NO_DOCS:
-            emit(q->scanDone(KSaneWidget::Information, i18n(sane_strstatus(m_scanThread->saneStatus()))));
-            alertUser(KSaneWidget::Information, i18n(sane_strstatus(m_scanThread->saneStatus())));
-            break;
-        case SANE_STATUS_UNSUPPORTED:
-        case SANE_STATUS_IO_ERROR:
-        case SANE_STATUS_NO_MEM:
-        case SANE_STATUS_INVAL:
-        case SANE_STATUS_JAMMED:
-        case SANE_STATUS_COVER_OPEN:
-        case SANE_STATUS_DEVICE_BUSY:
-        case SANE_STATUS_ACCESS_DENIED:
-            emit(q->scanDone(KSaneWidget::ErrorGeneral, i18n(sane_strstatus(m_scanThread->saneStatus()))));
-            alertUser(KSaneWidget::ErrorGeneral, i18n(sane_strstatus(m_scanThread->saneStatus())));
-            break;
+        QString message;
+        const KSaneCore::ScanStatus status = KSaneScanSession::scanStatus(thread->saneStatus(), message);
+        // a cancelled scan is not reported
+        if (status != KSaneCore::NoError) {
+            message = i18n(sane_strstatus(thread->saneStatus()));
+            emit(q->scanDone((KSaneWidget::ScanStatus)status, message));
+            alertUser(status, message);
         }
     }
 
+    finishScan();
+}
+
+QString KSaneWidgetPrivate::stalledMessage()
+{
+    return i18n("The scanner stopped sending data and the scan was cancelled.");
+}
+
+QString KSaneWidgetPrivate::abandonedMessage()
+{
+    return i18n("The scanner stopped sending data and does not respond. Please close the device and check the scanner.");
+}
+
+void KSaneWidgetPrivate::finishScan()
+{
     sane_cancel(m_saneHandle);
 
     // clear the highlight
     m_previewViewer->setHighlightArea(0, 0, 1, 1);
     setBusy(false);
     m_scanOngoing = false;
+    m_scanClaim.storeRelease(0);
+    armButtonScan();
+}
+
+void KSaneWidgetPrivate::startNextPage()
+{
+    if (m_session->thread() == nullptr) {
+        return;
+    }
+    m_updProgressTmr.start();
+    m_session->thread()->start();
+}
+
+void KSaneWidgetPrivate::scanAbandoned()
+{
+    m_updProgressTmr.stop();
+    m_previewViewer->setHighlightArea(0, 0, 1, 1);
+    setBusy(false);
+    m_scanOngoing = false;
+    m_scanClaim.storeRelease(0);
+    m_optsTabWidget->setDisabled(true);
+    m_previewViewer->setDisabled(true);
+    m_btnFrame->setDisabled(true);
+
+    const QString message = abandonedMessage();
+    emit(q->scanDone(KSaneWidget::ErrorStalled, message));
+    alertUser(KSaneWidget::ErrorStalled, message);
+
+    if (m_closeDevicePending) {
+        q->closeDevice();
+    }
 }
 
 void KSaneWidgetPrivate::setBusy(bool busy)
@@ -1068,14 +1400,17 @@ void KSaneWidgetPrivate::setBusy(bool busy)
         m_warmingUp->show();
         m_activityFrame->hide();
         m_btnFrame->hide();
-        m_optionPollTmr.stop();
+        // the scan and preview threads use the handle without the device mutex
+        if (m_optPoller) {
+            m_optPoller->pause();
+        }
         emit(q->scanProgress(0));
     } else {
         m_warmingUp->hide();
         m_activityFrame->hide();
         m_btnFrame->show();
-        if (m_pollList.size() > 0) {
-            m_optionPollTmr.start();
+        if (m_optPoller) {
+            m_optPoller->resume();
         }
         emit(q->scanProgress(100));
     }
@@ -1113,6 +1448,11 @@ void KSaneWidgetPrivate::checkInvert()
     }
 }
 
+void KSaneWidgetPrivate::setSoftwareGamma(int bri, int con, int gam)
+{
+    m_gammaStage.setValues(bri, con, gam);
+}
+
 void KSaneWidgetPrivate::invertPreview()
 {
     m_previewImg.invertPixels();
@@ -1140,11 +1480,15 @@ void KSaneWidgetPrivate::updateProgress()
             }
         }
     } else {
-        if (!m_progressBar->isVisible() && (m_scanThread->saneStartDone())) {
+        KSaneScanThread *thread = m_session->thread();
+        if (thread == nullptr) {
+            return;
+        }
+        if (!m_progressBar->isVisible() && (thread->saneStartDone())) {
             m_warmingUp->hide();
             m_activityFrame->show();
         }
-        progress = m_scanThread->scanProgress();
+        progress = thread->scanProgress();
         m_previewViewer->setHighlightShown(progress);
     }
 
@@ -1157,6 +1501,7 @@ void KSaneWidgetPrivate::alertUser(int type, const QString &strStatus)
     if (q->receivers(SIGNAL(userMessage(int,QString))) == 0) {
         switch (type) {
         case KSaneWidget::ErrorGeneral:
+        case KSaneWidget::ErrorStalled:
             QMessageBox::critical(nullptr, i18nc("@title:window", "General Error"), strStatus);
             break;
         default:
@@ -1168,11 +1513,141 @@ void KSaneWidgetPrivate::alertUser(int type, const QString &strStatus)
     }
 }
 
-void KSaneWidgetPrivate::pollPollOptions()
+void KSaneWidgetPrivate::updatePollList()
+{
+    if (m_optPoller == nullptr) {
+        return;
+    }
+
+    // An option is only polled if somebody is interested in the value: an application
+    // listening to buttonPressed() or a visible option widget.
+    QList<KSaneOption *> polled;
+    for (int i = 0; i < m_pollList.size(); ++i) {
+        KSaneOption *option = m_pollList.at(i);
+        if (option->state() == KSaneOption::STATE_HIDDEN) {
+            continue;
+        }
+        bool isButton = (qobject_cast<KSaneOptCheckBox *>(option) != nullptr);
+        if ((option == m_scanButtonOpt) ||
+                (isButton && m_buttonListeners) ||
+                ((option->widget() != nullptr) && option->widget()->isVisible())) {
+            polled.append(option);
+        }
+    }
+    m_optPoller->setOptions(polled);
+}
+
+KSaneOption *KSaneWidgetPrivate::resolveScanButton()
 {
-    for (int i = 1; i < m_pollList.size(); ++i) {
-        m_pollList.at(i)->readValue();
+    m_scanButtonOpt = nullptr;
+    if (!m_scanButtonName.isEmpty()) {
+        KSaneOption *option = getOption(m_scanButtonName);
+        if ((option != nullptr) && m_pollList.contains(option)) {
+            m_scanButtonOpt = option;
+        }
+    }
+    if (m_optPoller) {
+        m_optPoller->setScanButton(m_scanButtonOpt);
     }
+    updatePollList();
+    armButtonScan();
+    return m_scanButtonOpt;
+}
+
+void KSaneWidgetPrivate::armButtonScan()
+{
+    QMutexLocker locker(&m_buttonScanMutex);
+    m_buttonScanArmed = false;
+    m_buttonScanWrites.clear();
+
+    if ((m_scanButtonOpt == nullptr) || (m_session->thread() == nullptr) ||
+            m_scanOngoing || (m_scanClaim.loadAcquire() != 0)) {
+        return;
+    }
+
+    // Prepare the first scan job, so that the poller thread only needs to write
+    // the scan area and start the scan thread when the button is pressed.
+    planScanJobs();
+    const ScanJob &job = m_scanJobs.first();
+    if ((m_optTlX != nullptr) && (m_optTlY != nullptr) && (m_optBrX != nullptr) && (m_optBrY != nullptr)) {
+        float max_x, max_y;
+        m_optBrX->getMaxValue(max_x);
+        m_optBrY->getMaxValue(max_y);
+
+        KSaneOption *options[4] = { m_optTlX, m_optTlY, m_optBrX, m_optBrY };
+        float values[4] = { (float)job.area.left() * max_x, (float)job.area.top() * max_y,
+                            (float)job.area.right() * max_x, (float)job.area.bottom() * max_y };
+        for (int i = 0; i < 4; i++) {
+            RawOptionWrite write;
+            write.index = options[i]->index();
+            if (!options[i]->toRawValue(values[i], write.data)) {
+                return;
+            }
+            m_buttonScanWrites.append(write);
+        }
+    }
+    m_selIndex = job.indices.first();
+    m_session->thread()->setImageInverted(m_invertColors->isChecked());
+    m_session->thread()->setCropRegions(job.regions);
+    m_buttonScanArmed = true;
+}
+
+void KSaneWidgetPrivate::startButtonScan()
+{
+    // This is executed in the poller thread. Only the prepared data, the option
+    // worker and the scan thread may be used here.
+    QElapsedTimer timer;
+    timer.start();
+
+    QMutexLocker locker(&m_buttonScanMutex);
+    if (!m_buttonScanArmed || !m_scanClaim.testAndSetOrdered(0, 1)) {
+        return;
+    }
+    m_buttonScanArmed = false;
+
+    // This poll round has finished reading. No further round may use the handle
+    // until oneFinalScanDone() resumes the polling.
+    m_optPoller->pause();
+
+    // the options set in the GUI must reach the device first
+    m_optWorker->waitForIdle();
+
+    SANE_Status status;
+    SANE_Int info;
+    m_optWorker->deviceMutex()->lock();
+    for (int i = 0; i < m_buttonScanWrites.size(); i++) {
+        status = sane_control_option(m_saneHandle, m_buttonScanWrites.at(i).index, SANE_ACTION_SET_VALUE,
+                                     m_buttonScanWrites[i].data.data(), &info);
+        if (status != SANE_STATUS_GOOD) {
+            qDebug() << "Setting the scan area failed:" << sane_strstatus(status);
+        }
+    }
+    m_optWorker->deviceMutex()->unlock();
+
+    // queue the GUI update before the scan thread can finish
+    QMetaObject::invokeMethod(this, "buttonScanStarted", Qt::QueuedConnection);
+    m_session->thread()->setRequestTimer(timer);
+    m_session->thread()->start();
+}
+
+void KSaneWidgetPrivate::buttonScanStarted()
+{
+    m_scanOngoing = true;
+    m_isPreview = false;
+    setBusy(true);
+
+    const ScanJob &job = m_scanJobs.at(m_jobIndex);
+    if ((m_optTlX != nullptr) && (m_optTlY != nullptr) && (m_optBrX != nullptr) && (m_optBrY != nullptr)) {
+        m_previewViewer->setHighlightArea(job.area.left(), job.area.top(), job.area.right(), job.area.bottom());
+
+        // the scan area was written behind the back of the options
+        KSaneOption *options[4] = { m_optTlX, m_optTlY, m_optBrX, m_optBrY };
+        for (int i = 0; i < 4; i++) {
+            options[i]->invalidateValueCache();
+            options[i]->readValueAsync();
+        }
+    }
+    m_updProgressTmr.start();
 }
 
 }  // NameSpace KSaneIface
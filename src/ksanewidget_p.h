@@ -39,10 +39,13 @@ extern "C"
 #include <QWidget>
 #include <QCheckBox>
 #include <QTimer>
+#include <QHash>
 #include <QTime>
 #include <QProgressBar>
 #include <QTabWidget>
 #include <QPushButton>
+#include <QMutex>
+#include <QAtomicInt>
 
 #include "ksanewidget.h"
 #include "ksaneoption.h"
@@ -51,15 +54,32 @@ extern "C"
 #include "labeledcheckbox.h"
 #include "splittercollapser.h"
 #include "ksanescanthread.h"
+#include "ksaneoptionworker.h"
+#include "ksaneoptionpoller.h"
 #include "ksanepreviewthread.h"
 #include "ksanefinddevicesthread.h"
 #include "ksaneauth.h"
+#include "ksanepipeline.h"
+#include "ksanescansession.h"
+#include "ksanegammastage.h"
 
 #define IMG_DATA_R_SIZE 100000
 
 /** This namespace collects all methods and classes in LibKSane. */
 namespace KSaneIface
 {
+/** One scan pass of a final scan. */
+struct ScanJob {
+    QRectF        area;     // the scanned area relative to the whole scan area
+    QList<int>    indices;  // the viewer indices of the selections in this pass
+    QList<QRectF> regions;  // the selections relative to area if more than one
+};
+
+struct RawOptionWrite {
+    int        index;
+    QByteArray data;
+};
+
 class KSaneWidgetPrivate: public QObject
 {
     Q_OBJECT
@@ -72,17 +92,46 @@ public:
     void setDefaultValues();
     void setBusy(bool busy);
     KSaneOption *getOption(const QString &name);
-    KSaneWidget::ImageFormat getImgFormat(SANE_Parameters &params);
-    int getBytesPerLines(SANE_Parameters &params);
+    void rebuildOptionHash();
+    void updateGammaSplit();
+    void updateOptionLayout();
+
+    /** Option reloads between beginOptionBatch() and commitOptionBatch() only read the
+     * changed descriptors. The values and the layout are updated once at the commit. */
+    void beginOptionBatch();
+    void commitOptionBatch();
+    int  writeOrder(KSaneOption *option) const;
+    bool valueMayDependOn(KSaneOption *option, KSaneOption *writer) const;
+    bool needsValueRead(KSaneOption *option) const;
+    void planScanJobs();
+    void startScanJob();
+    KSaneOption *resolveScanButton();
+    /** Reset the device and the interface after the last page of a final scan. */
+    void finishScan();
+    /** The translated messages of the scans that the stall watchdog stopped. */
+    static QString stalledMessage();
+    static QString abandonedMessage();
 
 public Q_SLOTS:
     void devListUpdated();
     void signalDevListUpdate();
+    void signalDevicesChanged();
+    void signalDeviceFound(const KSaneIface::KSaneWidget::DeviceInfo &device);
     void startFinalScan();
     void startPreviewScan();
     void previewScanDone();
     void oneFinalScanDone();
+    void scanAbandoned();
+    /** Start the next page of a batch scan. */
+    void startNextPage();
     void updateProgress();
+    void updatePollList();
+    void createOtherOptions();
+    void createGammaWidgets();
+    void armButtonScan();
+    /** This slot is called in the poller thread when the scan button is pressed. */
+    void startButtonScan();
+    void buttonScanStarted();
 
 private Q_SLOTS:
     void scheduleValReload();
@@ -96,7 +145,7 @@ private Q_SLOTS:
 
     void checkInvert();
     void invertPreview();
-    void pollPollOptions();
+    void setSoftwareGamma(int bri, int con, int gam);
 
 public:
     void alertUser(int type, const QString &strStatus);
@@ -107,8 +156,10 @@ public:
     QScrollArea        *m_basicScrollA;
     QWidget            *m_basicOptsTab;
     QWidget            *m_colorOpts;
+    QWidget            *m_gammaFrame;
     QScrollArea        *m_otherScrollA;
     QWidget            *m_otherOptsTab;
+    bool                m_otherOptsBuilt;
     LabeledCheckbox    *m_invertColors;
 
     QSplitter          *m_splitter;
@@ -138,6 +189,10 @@ public:
 
     // Option variables
     QList<KSaneOption *> m_optList;
+    QHash<QString, KSaneOption *> m_optHash;
+    int                 m_batchDepth;
+    bool                m_batchReloadPending;
+    QList<KSaneOption *> m_batchReloads;
     QList<KSaneOption *> m_pollList;
     KSaneOption        *m_optSource;
     KSaneOption        *m_optNegative;
@@ -157,6 +212,9 @@ public:
     KSaneOption        *m_optGamB;
     LabeledCheckbox    *m_splitGamChB;
     LabeledGamma       *m_commonGamma;
+    // used when the device has no gamma tables
+    LabeledGamma       *m_softGamma;
+    KSaneGammaStage     m_gammaStage;
     KSaneOption        *m_optWaitForBtn;
 
     // preview variables
@@ -166,8 +224,11 @@ public:
     QImage              m_previewImg;
     bool                m_isPreview;
     bool                m_autoSelect;
+    bool                m_singlePassSel;
 
     int                 m_selIndex;
+    QList<ScanJob>      m_scanJobs;
+    int                 m_jobIndex;
 
     bool                m_scanOngoing;
     bool                m_closeDevicePending;
@@ -178,9 +239,23 @@ public:
     // option handling
     QTimer              m_readValsTmr;
     QTimer              m_updProgressTmr;
-    QTimer              m_optionPollTmr;
-    KSaneScanThread    *m_scanThread;
+    KSanePipeline      *m_pipeline;
+    KSaneScanSession   *m_session;
     KSanePreviewThread *m_previewThread;
+    KSaneOptionWorker  *m_optWorker;
+    KSaneOptionPoller  *m_optPoller;
+    int                 m_pollMinInterval;
+    int                 m_pollMaxInterval;
+    bool                m_buttonListeners;
+
+    // scan on button
+    QString             m_scanButtonName;
+    KSaneOption        *m_scanButtonOpt;
+    QMutex              m_buttonScanMutex;
+    bool                m_buttonScanArmed;       // protected by m_buttonScanMutex
+    QList<RawOptionWrite> m_buttonScanWrites;    // protected by m_buttonScanMutex
+    QAtomicInt          m_scanClaim;             // 1 while a scan is started or ongoing
+    int                 m_buttonScanLatency;
 
     QString             m_saneUserName;
     QString             m_sanePassword;
@@ -70,7 +70,7 @@ bool KSaneOptButton::hasGui()
 void KSaneOptButton::buttonClicked()
 {
     unsigned char data[4];
-    writeData(data);
+    writeDataAsync(data);
 }
 
 }  // NameSpace KSaneIface
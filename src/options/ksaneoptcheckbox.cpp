@@ -66,12 +66,21 @@ void KSaneOptCheckBox::createWidget(QWidget *parent)
 }
 
 void KSaneOptCheckBox::checkboxChanged(bool toggled)
+{
+    writeValue(toggled, true);
+}
+
+void KSaneOptCheckBox::writeValue(bool toggled, bool async)
 {
     unsigned char data[4];
 
     m_checked = toggled;
     fromSANE_Word(data, (toggled) ? 1 : 0);
-    writeData(data);
+    if (async) {
+        writeDataAsync(data);
+    } else {
+        writeData(data);
+    }
 }
 
 void KSaneOptCheckBox::readValue()
@@ -82,14 +91,16 @@ void KSaneOptCheckBox::readValue()
 
     // read the current value
     QVarLengthArray<unsigned char> data(m_optDesc->size);
-    SANE_Status status;
-    SANE_Int res;
-    status = sane_control_option(m_handle, m_index, SANE_ACTION_GET_VALUE, data.data(), &res);
-    if (status != SANE_STATUS_GOOD) {
+    if (!readData(data.data())) {
         return;
     }
+    applyValue(data.data());
+}
+
+void KSaneOptCheckBox::applyValue(unsigned char *data)
+{
     bool old = m_checked;
-    m_checked = (toSANE_Word(data.data()) != 0) ? true : false;
+    m_checked = (toSANE_Word(data) != 0) ? true : false;
     if (m_checkbox) {
         m_checkbox->setChecked(m_checked);
     }
@@ -112,7 +123,7 @@ bool KSaneOptCheckBox::setValue(float val)
     if (state() == STATE_HIDDEN) {
         return false;
     }
-    checkboxChanged(val == 0);
+    writeValue(val == 0, false);
     readValue();
     return true;
 }
@@ -133,9 +144,9 @@ bool KSaneOptCheckBox::setValue(const QString &val)
     }
     if ((val.compare(QStringLiteral("true"), Qt::CaseInsensitive) == 0) ||
             (val.compare(QStringLiteral("1")) == 0)) {
-        checkboxChanged(true);
+        writeValue(true, false);
     } else {
-        checkboxChanged(false);
+        writeValue(false, false);
     }
     readValue();
     return true;
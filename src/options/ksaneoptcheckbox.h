@@ -52,6 +52,9 @@ public:
     bool setValue(const QString &val) override;
     bool hasGui() override;
 
+protected:
+    void applyValue(unsigned char *data) override;
+
 private Q_SLOTS:
     void checkboxChanged(bool toggled);
 
@@ -59,6 +62,8 @@ Q_SIGNALS:
     void buttonPressed(const QString &optionName, const QString &optionLabel, bool pressed);
 
 private:
+    void writeValue(bool toggled, bool async);
+
     LabeledCheckbox *m_checkbox;
     bool             m_checked;
 };
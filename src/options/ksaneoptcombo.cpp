@@ -65,14 +65,15 @@ void KSaneOptCombo::readValue()
 
     // read that current value
     QVarLengthArray<unsigned char> data(m_optDesc->size);
-    SANE_Status status;
-    SANE_Int res;
-    status = sane_control_option(m_handle, m_index, SANE_ACTION_GET_VALUE, data.data(), &res);
-    if (status != SANE_STATUS_GOOD) {
+    if (!readData(data.data())) {
         return;
     }
+    applyValue(data.data());
+}
 
-    m_currentText = getSaneComboString(data.data());
+void KSaneOptCombo::applyValue(unsigned char *data)
+{
+    m_currentText = getSaneComboString(data);
     if (m_combo != nullptr) {
         if (m_combo->currentText() != m_currentText) {
             m_combo->setCurrentText(m_currentText);
@@ -210,8 +211,11 @@ void KSaneOptCombo::comboboxChangedIndex(int i)
         qDebug() << "can not handle type:" << m_optDesc->type;
         return;
     }
-    writeData(dataPtr);
-    readValue();
+    writeDataAsync(dataPtr);
+    if (m_combo) {
+        m_currentText = m_combo->currentText();
+    }
+    readValueAsync();
     emit valueChanged();
 }
 
@@ -248,11 +252,7 @@ bool KSaneOptCombo::getValue(float &val)
 
     // read that current value
     QVarLengthArray<unsigned char> data(m_optDesc->size);
-    SANE_Status status;
-    SANE_Int res;
-    status = sane_control_option(m_handle, m_index, SANE_ACTION_GET_VALUE, data.data(), &res);
-    if (status != SANE_STATUS_GOOD) {
-        qDebug() << m_optDesc->name << "sane_control_option returned" << status;
+    if (!readData(data.data())) {
         return false;
     }
 
@@ -54,6 +54,9 @@ public:
     bool setValue(const QString &val) override;
     bool hasGui() override;
 
+protected:
+    void applyValue(unsigned char *data) override;
+
 private Q_SLOTS:
     void comboboxChangedIndex(int val);
 
@@ -64,12 +64,23 @@ void KSaneOptEntry::createWidget(QWidget *parent)
 }
 
 void KSaneOptEntry::entryChanged(const QString &text)
+{
+    writeValue(text, true);
+}
+
+void KSaneOptEntry::writeValue(const QString &text, bool async)
 {
     QString tmp;
     tmp += text.left(m_optDesc->size);
     if (tmp != text) {
-        m_entry->setText(tmp);
-        writeData(tmp.toLatin1().data());
+        if (m_entry != nullptr) {
+            m_entry->setText(tmp);
+        }
+        if (async) {
+            writeDataAsync(tmp.toLatin1().data());
+        } else {
+            writeData(tmp.toLatin1().data());
+        }
     }
 }
 
@@ -81,14 +92,15 @@ void KSaneOptEntry::readValue()
 
     // read that current value
     QVarLengthArray<unsigned char> data(m_optDesc->size);
-    SANE_Status status;
-    SANE_Int res;
-    status = sane_control_option(m_handle, m_index, SANE_ACTION_GET_VALUE, data.data(), &res);
-    if (status != SANE_STATUS_GOOD) {
+    if (!readData(data.data())) {
         return;
     }
+    applyValue(data.data());
+}
 
-    m_string = QString::fromUtf8(reinterpret_cast<char *>(data.data()));
+void KSaneOptEntry::applyValue(unsigned char *data)
+{
+    m_string = QString::fromUtf8(reinterpret_cast<char *>(data));
     if (m_entry != nullptr) {
         m_entry->setText(m_string);
     }
@@ -117,7 +129,7 @@ bool KSaneOptEntry::setValue(const QString &val)
     if (state() == STATE_HIDDEN) {
         return false;
     }
-    entryChanged(val);
+    writeValue(val, false);
     readValue();
     return true;
 }
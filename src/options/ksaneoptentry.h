@@ -52,10 +52,15 @@ public:
     bool setValue(const QString &val) override;
     bool hasGui() override;
 
+protected:
+    void applyValue(unsigned char *data) override;
+
 private Q_SLOTS:
     void entryChanged(const QString &text);
 
 private:
+    void writeValue(const QString &text, bool async);
+
     LabeledEntry *m_entry;
     QString       m_string;
 };
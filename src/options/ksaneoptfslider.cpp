@@ -92,14 +92,15 @@ void KSaneOptFSlider::readValue()
 
     // read that current value
     QVarLengthArray<unsigned char> data(m_optDesc->size);
-    SANE_Status status;
-    SANE_Int res;
-    status = sane_control_option(m_handle, m_index, SANE_ACTION_GET_VALUE, data.data(), &res);
-    if (status != SANE_STATUS_GOOD) {
+    if (!readData(data.data())) {
         return;
     }
+    applyValue(data.data());
+}
 
-    m_fVal = SANE_UNFIX(toSANE_Word(data.data()));
+void KSaneOptFSlider::applyValue(unsigned char *data)
+{
+    m_fVal = SANE_UNFIX(toSANE_Word(data));
     if (m_slider != nullptr) {
         if (((m_slider->value() - m_fVal) >= m_minChange) ||
                 ((m_fVal - m_slider->value()) >= m_minChange)) {
@@ -110,6 +111,11 @@ void KSaneOptFSlider::readValue()
 }
 
 void KSaneOptFSlider::sliderChanged(float val)
+{
+    writeValue(val, true);
+}
+
+void KSaneOptFSlider::writeValue(float val, bool async)
 {
     if (((val - m_fVal) >= m_minChange) || ((m_fVal - val) >= m_minChange)) {
         unsigned char data[4];
@@ -118,7 +124,11 @@ void KSaneOptFSlider::sliderChanged(float val)
         m_fVal = val;
         fixed = SANE_FIX(val);
         fromSANE_Word(data, fixed);
-        writeData(data);
+        if (async) {
+            writeDataAsync(data);
+        } else {
+            writeData(data);
+        }
     }
 }
 
@@ -156,7 +166,7 @@ bool KSaneOptFSlider::setValue(float val)
     if (state() == STATE_HIDDEN) {
         return false;
     }
-    sliderChanged(val);
+    writeValue(val, false);
     readValue();
     return true;
 }
@@ -175,7 +185,7 @@ bool KSaneOptFSlider::setValue(const QString &val)
     if (state() == STATE_HIDDEN) {
         return false;
     }
-    sliderChanged(val.toFloat());
+    writeValue(val.toFloat(), false);
     readValue();
     return true;
 }
@@ -58,10 +58,15 @@ public:
 Q_SIGNALS:
     void fValueRead(float);
 
+protected:
+    void applyValue(unsigned char *data) override;
+
 private Q_SLOTS:
     void sliderChanged(float val);
 
 private:
+    void writeValue(float val, bool async);
+
     LabeledFSlider *m_slider;
     float           m_fVal;
     float           m_minChange;
@@ -31,6 +31,7 @@
 #include "labeledgamma.h"
 
 #include <QtCore/QVarLengthArray>
+#include <QtCore/QStringList>
 
 #include <QDebug>
 
@@ -38,7 +39,7 @@ namespace KSaneIface
 {
 
 KSaneOptGamma::KSaneOptGamma(const SANE_Handle handle, const int index)
-    : KSaneOption(handle, index), m_gamma(nullptr)
+    : KSaneOption(handle, index), m_gamma(nullptr), m_brightness(0), m_contrast(0), m_gammaValue(100)
 {
 }
 
@@ -60,7 +61,10 @@ void KSaneOptGamma::createWidget(QWidget *parent)
                                           sane_i18n(m_optDesc->title),
                                           m_optDesc->size / sizeof(SANE_Word),
                                           m_optDesc->constraint.range->max);
+    // the values can have been set before the widget was created
+    m_gamma->setValues(m_brightness, m_contrast, m_gammaValue);
     connect(m_gamma, &LabeledGamma::gammaTableChanged, this, &KSaneOptGamma::gammaTableChanged);
+    connect(m_gamma, &LabeledGamma::gammaChanged, this, &KSaneOptGamma::gammaChanged);
     if (strcmp(m_optDesc->name, SANE_NAME_GAMMA_VECTOR_R) == 0) {
         m_gamma->setColor(Qt::red);
     }
@@ -78,8 +82,35 @@ void KSaneOptGamma::createWidget(QWidget *parent)
 
 void KSaneOptGamma::gammaTableChanged(const QVector<int> &gam_tbl)
 {
+    // the table is copied by the option worker, so only the last table of a drag is written
     QVector<int> copy = gam_tbl;
-    writeData(copy.data());
+    writeDataAsync(copy.data());
+}
+
+void KSaneOptGamma::gammaChanged(int bri, int con, int gam)
+{
+    m_brightness = bri;
+    m_contrast   = con;
+    m_gammaValue = gam;
+}
+
+void KSaneOptGamma::setGammaValues(int bri, int con, int gam)
+{
+    if (m_gamma) {
+        m_gamma->setValues(bri, con, gam);
+        return;
+    }
+    if (!m_optDesc) {
+        return;
+    }
+
+    m_brightness = bri;
+    m_contrast   = con;
+    m_gammaValue = gam;
+
+    QVector<int> gammaTable(m_optDesc->size / sizeof(SANE_Word));
+    LabeledGamma::calculateGammaTable(gammaTable, bri, con, gam, m_optDesc->constraint.range->max);
+    writeDataAsync(gammaTable.data());
 }
 
 void KSaneOptGamma::readValue()
@@ -88,6 +119,11 @@ void KSaneOptGamma::readValue()
     // not easy nor fast.. ergo not done
 }
 
+void KSaneOptGamma::readValueAsync()
+{
+    // see readValue()
+}
+
 bool KSaneOptGamma::getValue(float &)
 {
     return false;
@@ -99,30 +135,47 @@ bool KSaneOptGamma::setValue(float)
 
 bool KSaneOptGamma::getValue(QString &val)
 {
-    if (!m_gamma) {
-        return false;
-    }
     if (state() == STATE_HIDDEN) {
         return false;
     }
-    int bri;
-    int con;
-    int gam;
-    m_gamma->getValues(bri, con, gam);
-    val = QString::asprintf("%d:%d:%d", bri, con, gam);
+    val = QString::asprintf("%d:%d:%d", m_brightness, m_contrast, m_gammaValue);
     return true;
 }
 
 bool KSaneOptGamma::setValue(const QString &val)
 {
-    if (!m_gamma) {
+    if (state() == STATE_HIDDEN) {
         return false;
     }
-    if (state() == STATE_HIDDEN) {
+
+    QStringList gammaValues = val.split(QLatin1Char(':'));
+    if (gammaValues.size() != 3) {
         return false;
     }
+    bool ok;
+    int bri = gammaValues.at(0).toInt(&ok);
+    if (!ok) {
+        return false;
+    }
+    int con = gammaValues.at(1).toInt(&ok);
+    if (!ok) {
+        return false;
+    }
+    int gam = gammaValues.at(2).toInt(&ok);
+    if (!ok) {
+        return false;
+    }
+
+    setGammaValues(bri, con, gam);
+    return true;
+}
 
-    m_gamma->setValues(val);
+bool KSaneOptGamma::getMaxValue(float &max)
+{
+    if (!m_optDesc) {
+        return false;
+    }
+    max = m_optDesc->constraint.range->max;
     return true;
 }
 
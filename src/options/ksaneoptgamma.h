@@ -45,18 +45,29 @@ public:
     void createWidget(QWidget *parent) override;
 
     void readValue() override;
+    void readValueAsync() override;
 
     bool getValue(float &val) override;
     bool setValue(float val) override;
     bool getValue(QString &val) override;
     bool setValue(const QString &val) override;
+    bool getMaxValue(float &max) override;
     bool hasGui() override;
 
+public Q_SLOTS:
+    /** Set brightness, contrast and gamma. Without a widget the table is calculated
+     * and written directly. */
+    void setGammaValues(int bri, int con, int gam);
+
 private Q_SLOTS:
     void gammaTableChanged(const QVector<int> &gam_tbl);
+    void gammaChanged(int bri, int con, int gam);
 
 private:
     LabeledGamma *m_gamma;
+    int           m_brightness;
+    int           m_contrast;
+    int           m_gammaValue;
 };
 
 }  // NameSpace KSaneIface
@@ -29,7 +29,9 @@
 #include "ksaneoption.h"
 
 #include "ksaneoptionwidget.h"
+#include "ksaneoptionworker.h"
 
+#include <QMutexLocker>
 #include <QDebug>
 
 namespace KSaneIface
@@ -40,6 +42,9 @@ KSaneOption::KSaneOption(const SANE_Handle handle, const int index)
 {
     m_widget = nullptr;
     m_data = nullptr;
+    m_valueCached = false;
+    m_worker = nullptr;
+    m_pendingWrites = 0;
     readOption();
 }
 
@@ -68,12 +73,83 @@ void KSaneOption::createWidget(QWidget *parent)
     readValue();
 }
 
+void KSaneOption::setWorker(KSaneOptionWorker *worker)
+{
+    m_worker = worker;
+    m_pendingWrites = 0;
+}
+
+QMutex *KSaneOption::deviceLock()
+{
+    if (m_worker == nullptr) {
+        return nullptr;
+    }
+    // synchronous access must see the result of the queued jobs
+    m_worker->waitForIdle();
+    return m_worker->deviceMutex();
+}
+
 void KSaneOption::readOption()
 {
+    QMutexLocker locker(deviceLock());
     m_optDesc = sane_get_option_descriptor(m_handle, m_index);
+    m_descSnapshot = descriptorSnapshot(m_optDesc);
+    // the size or the constraint of the value can have changed
+    m_valueCached = false;
     updateVisibility();
 }
 
+bool KSaneOption::descriptorChanged()
+{
+    // the old descriptor pointer is not valid after an option reload
+    QMutexLocker locker(deviceLock());
+    m_optDesc = sane_get_option_descriptor(m_handle, m_index);
+    return descriptorSnapshot(m_optDesc) != m_descSnapshot;
+}
+
+QByteArray KSaneOption::descriptorSnapshot(const SANE_Option_Descriptor *optDesc)
+{
+    QByteArray snapshot;
+    if (!optDesc) {
+        return snapshot;
+    }
+
+    // the strings are stored with the terminating null
+    snapshot.append(optDesc->name ? optDesc->name : "").append('\0');
+    snapshot.append(optDesc->title ? optDesc->title : "").append('\0');
+    snapshot.append(optDesc->desc ? optDesc->desc : "").append('\0');
+    snapshot.append((const char *)&optDesc->type, sizeof(optDesc->type));
+    snapshot.append((const char *)&optDesc->unit, sizeof(optDesc->unit));
+    snapshot.append((const char *)&optDesc->size, sizeof(optDesc->size));
+    snapshot.append((const char *)&optDesc->cap, sizeof(optDesc->cap));
+    snapshot.append((const char *)&optDesc->constraint_type, sizeof(optDesc->constraint_type));
+
+    switch (optDesc->constraint_type) {
+    case SANE_CONSTRAINT_NONE:
+        break;
+    case SANE_CONSTRAINT_RANGE:
+        if (optDesc->constraint.range) {
+            snapshot.append((const char *)optDesc->constraint.range, sizeof(SANE_Range));
+        }
+        break;
+    case SANE_CONSTRAINT_WORD_LIST:
+        if (optDesc->constraint.word_list) {
+            // the first word is the length of the list
+            snapshot.append((const char *)optDesc->constraint.word_list,
+                            (optDesc->constraint.word_list[0] + 1) * sizeof(SANE_Word));
+        }
+        break;
+    case SANE_CONSTRAINT_STRING_LIST:
+        if (optDesc->constraint.string_list) {
+            for (int i = 0; optDesc->constraint.string_list[i] != nullptr; i++) {
+                snapshot.append(optDesc->constraint.string_list[i]).append('\0');
+            }
+        }
+        break;
+    }
+    return snapshot;
+}
+
 void KSaneOption::updateVisibility()
 {
     if (!m_widget) {
@@ -126,6 +202,68 @@ QString KSaneOption::name() const
     return QString::fromUtf8(m_optDesc->name);
 }
 
+int KSaneOption::index() const
+{
+    return m_index;
+}
+
+int KSaneOption::valueSize() const
+{
+    if (m_optDesc == nullptr) {
+        return 0;
+    }
+    return m_optDesc->size;
+}
+
+QAtomicInt KSaneOption::s_elidedWrites;
+
+QByteArray KSaneOption::valueBytes(const void *data) const
+{
+    if ((data == nullptr) || (m_optDesc == nullptr)) {
+        return QByteArray();
+    }
+    if (m_optDesc->type == SANE_TYPE_STRING) {
+        // the buffer of a written string can be shorter than the option size
+        return QByteArray((const char *)data, qstrnlen((const char *)data, m_optDesc->size));
+    }
+    return QByteArray((const char *)data, m_optDesc->size);
+}
+
+bool KSaneOption::readData(unsigned char *data)
+{
+    SANE_Status status;
+    SANE_Int res;
+
+    QMutexLocker locker(deviceLock());
+    status = sane_control_option(m_handle, m_index, SANE_ACTION_GET_VALUE, data, &res);
+    if (status != SANE_STATUS_GOOD) {
+        qDebug() << m_optDesc->name << "sane_control_option returned" << status;
+        m_valueCached = false;
+        return false;
+    }
+    m_lastValue = valueBytes(data);
+    m_valueCached = true;
+    return true;
+}
+
+void KSaneOption::invalidateValueCache()
+{
+    m_valueCached = false;
+}
+
+void KSaneOption::refreshValue()
+{
+    // the widget keeps the value of an option with a widget up to date
+    if ((m_widget == nullptr) && !m_valueCached) {
+        readValue();
+    }
+}
+
+int KSaneOption::elidedWrites()
+{
+    return s_elidedWrites.load();
+}
+
 bool KSaneOption::writeData(void *data)
 {
     SANE_Status status;
@@ -135,16 +273,32 @@ bool KSaneOption::writeData(void *data)
         return false;
     }
 
+    // Skip the write if the device already has the value. Buttons are actions and always written.
+    if (m_valueCached && (m_optDesc->type != SANE_TYPE_BUTTON) && (valueBytes(data) == m_lastValue)) {
+        s_elidedWrites.ref();
+        return true;
+    }
+
+    QMutexLocker locker(deviceLock());
     status = sane_control_option(m_handle, m_index, SANE_ACTION_SET_VALUE, data, &res);
+    locker.unlock();
     if (status != SANE_STATUS_GOOD) {
         qDebug() << m_optDesc->name << "sane_control_option returned:" << sane_strstatus(status);
+        m_valueCached = false;
         // write failed. re read the current setting
         readValue();
         return false;
     }
-    if ((res & SANE_INFO_INEXACT) && (m_widget != nullptr)) {
-        //qDebug() << "write was inexact. Reload value just in case...";
-        readValue();
+    if (res & SANE_INFO_INEXACT) {
+        // the device has some other value than the written one
+        m_valueCached = false;
+        if (m_widget != nullptr) {
+            //qDebug() << "write was inexact. Reload value just in case...";
+            readValue();
+        }
+    } else if (m_optDesc->type != SANE_TYPE_BUTTON) {
+        m_lastValue = valueBytes(data);
+        m_valueCached = true;
     }
 
     if (res & SANE_INFO_RELOAD_OPTIONS) {
@@ -158,8 +312,98 @@ bool KSaneOption::writeData(void *data)
     return true;
 }
 
+void KSaneOption::writeDataAsync(void *data)
+{
+    if (m_worker == nullptr) {
+        writeData(data);
+        return;
+    }
+
+    if (state() == STATE_DISABLED) {
+        return;
+    }
+
+    // A queued write can still change the value, so the cache is only trusted when
+    // nothing is pending.
+    if (m_valueCached && (m_pendingWrites == 0) &&
+            (m_optDesc->type != SANE_TYPE_BUTTON) && (valueBytes(data) == m_lastValue)) {
+        s_elidedWrites.ref();
+        return;
+    }
+
+    QByteArray value = valueBytes(data);
+    QByteArray buffer(qMax(m_optDesc->size, value.size()), '\0');
+    memcpy(buffer.data(), value.constData(), value.size());
+
+    m_valueCached = false;
+    if (m_worker->write(this, m_index, buffer)) {
+        m_pendingWrites++;
+    }
+}
+
+void KSaneOption::writeFinished(const QByteArray &data, int status, int info)
+{
+    if (m_pendingWrites > 0) {
+        m_pendingWrites--;
+    }
+
+    if (status != SANE_STATUS_GOOD) {
+        qDebug() << name() << "sane_control_option returned:" << sane_strstatus((SANE_Status)status);
+        m_valueCached = false;
+        // write failed. re read the current setting
+        readValueAsync();
+        return;
+    }
+    if (info & SANE_INFO_INEXACT) {
+        m_valueCached = false;
+        if (m_widget != nullptr) {
+            readValueAsync();
+        }
+    } else if ((m_optDesc != nullptr) && (m_optDesc->type != SANE_TYPE_BUTTON) && (m_pendingWrites == 0)) {
+        m_lastValue = valueBytes(data.constData());
+        m_valueCached = true;
+    }
+
+    if (info & SANE_INFO_RELOAD_OPTIONS) {
+        emit optsNeedReload();
+    } else if (info & SANE_INFO_RELOAD_PARAMS) {
+        emit valsNeedReload();
+    }
+}
+
+void KSaneOption::readValueAsync()
+{
+    if ((m_worker == nullptr) || !hasGui() || (m_optDesc == nullptr) || (m_optDesc->type == SANE_TYPE_BUTTON)) {
+        readValue();
+        return;
+    }
+    if (state() == STATE_HIDDEN) {
+        return;
+    }
+    m_worker->read(this, m_index, m_optDesc->size);
+}
+
+void KSaneOption::readFinished(const QByteArray &data, int status)
+{
+    if (status != SANE_STATUS_GOOD) {
+        qDebug() << name() << "sane_control_option returned" << sane_strstatus((SANE_Status)status);
+        m_valueCached = false;
+        return;
+    }
+    if (m_pendingWrites > 0) {
+        // the value is already outdated, a newer one is on its way to the device
+        return;
+    }
+    QByteArray value = data;
+    m_lastValue = valueBytes(value.constData());
+    m_valueCached = true;
+    applyValue((unsigned char *)value.data());
+}
+
 void KSaneOption::readValue() {}
 
+void KSaneOption::applyValue(unsigned char *) {}
+
 SANE_Word KSaneOption::toSANE_Word(unsigned char *data)
 {
     SANE_Word tmp;
@@ -223,11 +467,26 @@ int  KSaneOption::getUnit()
     return m_optDesc->unit;
 }
 
-bool KSaneOption::storeCurrentData()
+bool KSaneOption::toRawValue(float val, QByteArray &data)
 {
-    SANE_Status status;
-    SANE_Int res;
+    if ((m_optDesc == nullptr) || (m_optDesc->size != sizeof(SANE_Word))) {
+        return false;
+    }
+    data.resize(sizeof(SANE_Word));
+    switch (m_optDesc->type) {
+    case SANE_TYPE_INT:
+        fromSANE_Word((unsigned char *)data.data(), (SANE_Word)val);
+        return true;
+    case SANE_TYPE_FIXED:
+        fromSANE_Word((unsigned char *)data.data(), SANE_FIX(val));
+        return true;
+    default:
+        return false;
+    }
+}
 
+bool KSaneOption::storeCurrentData()
+{
     // check if we can read the value
     if (!hasGui()) {
         return false;
@@ -241,12 +500,7 @@ bool KSaneOption::storeCurrentData()
         free(m_data);
     }
     m_data = (unsigned char *)malloc(m_optDesc->size);
-    status = sane_control_option(m_handle, m_index, SANE_ACTION_GET_VALUE, m_data, &res);
-    if (status != SANE_STATUS_GOOD) {
-        qDebug() << m_optDesc->name << "sane_control_option returned" << status;
-        return false;
-    }
-    return true;
+    return readData(m_data);
 }
 
 bool KSaneOption::restoreSavedData()
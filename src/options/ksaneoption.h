@@ -32,6 +32,8 @@
 // Qt includes
 
 #include <QFrame>
+#include <QAtomicInt>
+#include <QMutex>
 
 //KDE includes
 
@@ -54,6 +56,7 @@ inline QString sane_i18n(const char *text) {
 }
 
 class KSaneOptionWidget;
+class KSaneOptionWorker;
 
 class KSaneOption : public QObject
 {
@@ -87,12 +90,33 @@ public:
     bool needsPolling() const;
     KSaneOptWState state() const;
     QString name() const;
+    int index() const;
+    /** @return the size of the value buffer in bytes. */
+    int valueSize() const;
 
     virtual void createWidget(QWidget *parent);
 
     virtual void readOption();
     virtual void readValue();
 
+    /** Set the thread that executes the reads and writes initiated by the widgets.
+     * Without a worker all device access is synchronous. */
+    void setWorker(KSaneOptionWorker *worker);
+
+    /** Read the value in the option worker and update the widget when the value arrives. */
+    virtual void readValueAsync();
+
+    /** Called in the GUI thread by the option worker when a queued write is done. */
+    void writeFinished(const QByteArray &data, int status, int info);
+
+    /** Called in the GUI thread by the option worker when a queued read is done. */
+    void readFinished(const QByteArray &data, int status);
+
+    /** This function fetches the option descriptor from the backend and compares it with
+     * the descriptor that was read with the last readOption().
+     * @return true if the descriptor, the capabilities or the constraint have changed. */
+    bool descriptorChanged();
+
     virtual bool getMinValue(float &max);
     virtual bool getMaxValue(float &max);
     virtual bool getValue(float &val);
@@ -101,9 +125,24 @@ public:
     virtual bool setValue(const QString &val);
     virtual int  getUnit();
 
+    /** Convert val to the raw value of an integer or fixed point option.
+     * @return false if the option has some other type. */
+    bool toRawValue(float val, QByteArray &data);
+
     bool storeCurrentData();
     bool restoreSavedData();
 
+    /** Forget the last known value, so that the next write is not skipped.
+     * This must be called when the device may have changed the value by itself. */
+    void invalidateValueCache();
+
+    /** Read the value from the device if the option has no widget and the last known
+     * value can be outdated. The values of options without a widget are only read on demand. */
+    void refreshValue();
+
+    /** @return the number of writes that were skipped because the device already had the value. */
+    static int elidedWrites();
+
 Q_SIGNALS:
     void optsNeedReload();
     void valsNeedReload();
@@ -113,15 +152,29 @@ protected:
     SANE_Word toSANE_Word(unsigned char *data);
     void fromSANE_Word(unsigned char *data, SANE_Word from);
     bool writeData(void *data);
+    void writeDataAsync(void *data);
+    bool readData(unsigned char *data);
+    /** Update the member value and the widget from the raw option value. */
+    virtual void applyValue(unsigned char *data);
+    QMutex *deviceLock();
+    QByteArray valueBytes(const void *data) const;
     KLocalizedString unitString();
     QString unitDoubleString();
     void updateVisibility();
+    static QByteArray descriptorSnapshot(const SANE_Option_Descriptor *optDesc);
 
     SANE_Handle                   m_handle;
     int                           m_index;
     const SANE_Option_Descriptor *m_optDesc; ///< This pointer is provided by sane
     unsigned char                *m_data;
     KSaneOptionWidget            *m_widget;
+    QByteArray                    m_descSnapshot;
+    QByteArray                    m_lastValue;
+    bool                          m_valueCached;
+    KSaneOptionWorker            *m_worker;
+    int                           m_pendingWrites;
+
+    static QAtomicInt             s_elidedWrites;
 };
 
 }  // NameSpace KSaneIface
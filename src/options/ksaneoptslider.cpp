@@ -66,14 +66,15 @@ void KSaneOptSlider::readValue()
 
     // read that current value
     QVarLengthArray<unsigned char> data(m_optDesc->size);
-    SANE_Status status;
-    SANE_Int res;
-    status = sane_control_option(m_handle, m_index, SANE_ACTION_GET_VALUE, data.data(), &res);
-    if (status != SANE_STATUS_GOOD) {
+    if (!readData(data.data())) {
         return;
     }
+    applyValue(data.data());
+}
 
-    m_iVal = toSANE_Word(data.data());
+void KSaneOptSlider::applyValue(unsigned char *data)
+{
+    m_iVal = toSANE_Word(data);
     if ((m_slider != nullptr) && (m_slider->value() != m_iVal)) {
         m_slider->setValue(m_iVal);
     }
@@ -100,6 +101,11 @@ void KSaneOptSlider::readOption()
 }
 
 void KSaneOptSlider::sliderChanged(int val)
+{
+    writeValue(val, true);
+}
+
+void KSaneOptSlider::writeValue(int val, bool async)
 {
     if (val == m_iVal) {
         return;
@@ -107,7 +113,11 @@ void KSaneOptSlider::sliderChanged(int val)
     unsigned char data[4];
     m_iVal = val;
     fromSANE_Word(data, val);
-    writeData(data);
+    if (async) {
+        writeDataAsync(data);
+    } else {
+        writeData(data);
+    }
 }
 
 bool KSaneOptSlider::getMinValue(float &val)
@@ -144,7 +154,7 @@ bool KSaneOptSlider::setValue(float val)
     if (state() == STATE_HIDDEN) {
         return false;
     }
-    sliderChanged((int)val);
+    writeValue((int)val, false);
     readValue();
     return true;
 }
@@ -163,7 +173,7 @@ bool KSaneOptSlider::setValue(const QString &val)
     if (state() == STATE_HIDDEN) {
         return false;
     }
-    sliderChanged(val.toInt());
+    writeValue(val.toInt(), false);
     readValue();
     return true;
 }
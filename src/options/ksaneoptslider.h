@@ -58,10 +58,15 @@ public:
 Q_SIGNALS:
     void fValueRead(float);
 
+protected:
+    void applyValue(unsigned char *data) override;
+
 private Q_SLOTS:
     void sliderChanged(int val);
 
 private:
+    void writeValue(int val, bool async);
+
     LabeledSlider *m_slider;
     int            m_iVal;
 };
@@ -28,13 +28,12 @@
 
 // Local includes
 #include "labeledgamma.h"
+#include "ksanegammastage.h"
 
 #include <QGroupBox>
 
 #include <klocalizedstring.h>
 
-#include <cmath>
-
 namespace KSaneIface
 {
 
@@ -180,34 +179,16 @@ int LabeledGamma::maxValue()
 }
 
 
-void LabeledGamma::calculateGT()
+void LabeledGamma::calculateGammaTable(QVector<int> &gammaTable, int bri, int con, int gam, double max)
 {
-    double gam      = 100.0 / m_gammaSlider->value();
-    double con      = (200.0 / (100.0 - m_contrastSlider->value())) - 1;
-    double halfMax  = m_maxValue / 2.0;
-    double bri      = (m_brightSlider->value() / halfMax) * m_maxValue;
-    double x;
-
-    for (int i = 0; i < m_gammaTable.size(); i++) {
-        // apply gamma
-        x = std::pow((double)i / m_gammaTable.size(), gam) * m_maxValue;
-
-        // apply contrast
-        x = (con * (x - halfMax)) + halfMax;
-
-        // apply brightness + rounding
-        x += bri + 0.5;
-
-        // ensure correct value
-        if (x > m_maxValue) {
-            x = m_maxValue;
-        }
-        if (x < 0) {
-            x = 0;
-        }
+    // the same curve is applied by the software gamma of the scan thread
+    KSaneGammaStage::calculateTable(gammaTable, bri, con, gam, max);
+}
 
-        m_gammaTable[i] = (int)x;
-    }
+void LabeledGamma::calculateGT()
+{
+    calculateGammaTable(m_gammaTable, m_brightSlider->value(), m_contrastSlider->value(),
+                        m_gammaSlider->value(), m_maxValue);
 
     m_gammaDisplay->update();
     emit gammaChanged(m_brightSlider->value(), m_contrastSlider->value(), m_gammaSlider->value());
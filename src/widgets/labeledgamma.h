@@ -68,6 +68,17 @@ public:
 
     bool getValues(int &bri, int &con, int &gam);
 
+    /**
+     * Calculate a gamma table without a widget.
+     *
+     * \param gammaTable is the table to fill. The size of the table is not changed.
+     * \param bri is the brightness
+     * \param con is the contrast
+     * \param gam is the gamma value (100 is linear)
+     * \param max is the maximum gamma-table-value
+     */
+    static void calculateGammaTable(QVector<int> &gammaTable, int bri, int con, int gam, double max);
+
 public Q_SLOTS:
     void setValues(int bri, int con, int gam);
     void setValues(const QString &values);
@@ -0,0 +1,222 @@
+/* ============================================================
+*
+* This file is part of the KDE project
+*
+* Date        : 2026-10-19
+* Description : Runtime and accuracy benchmark for the automatic selections.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) version 3, or any
+* later version accepted by the membership of KDE e.V. (or its
+* successor approved by the membership of KDE e.V.), which shall
+* act as a proxy defined in Section 6 of version 3 of the license.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* ============================================================ */
+
+// Usage: selectionbenchmark <directory> [iterations] [area]
+//
+// Every image in the directory can have a ground truth file with the same base
+// name and the suffix ".txt". The file contains one selection per line as
+// "x1 y1 x2 y2" in pixel coordinates of the image. Lines starting with '#' are
+// ignored. An image without a ground truth file is expected to have no selections.
+//
+// The result is printed to stdout as one JSON object per line and image,
+// followed by one summary line.
+
+#include "ksaneselectionfinder.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <QImageReader>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QDebug>
+
+#include <stdio.h>
+
+using namespace KSaneIface;
+
+static QList<QRectF> readGroundTruth(const QString &fileName)
+{
+    QList<QRectF> rects;
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return rects;
+    }
+    QTextStream stream(&file);
+    while (!stream.atEnd()) {
+        QString line = stream.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith(QLatin1Char('#'))) {
+            continue;
+        }
+        QStringList values = line.split(QLatin1Char(' '), QString::SkipEmptyParts);
+        if (values.size() != 4) {
+            qDebug() << "Invalid ground truth line in" << fileName << ":" << line;
+            continue;
+        }
+        rects.append(QRectF(QPointF(values[0].toDouble(), values[1].toDouble()),
+                            QPointF(values[2].toDouble(), values[3].toDouble())));
+    }
+    return rects;
+}
+
+static qreal intersectionOverUnion(const QRectF &a, const QRectF &b)
+{
+    QRectF intersection = a.normalized() & b.normalized();
+    qreal interArea = intersection.width() * intersection.height();
+    qreal unionArea = (a.width() * a.height()) + (b.width() * b.height()) - interArea;
+    if (unionArea <= 0) {
+        return 0;
+    }
+    return interArea / unionArea;
+}
+
+// Every ground truth rectangle is matched with the best overlapping found selection.
+// Found selections that do not belong to any ground truth rectangle count as zero.
+static qreal meanIoU(const QList<QRectF> &truth, const QList<QRectF> &found)
+{
+    if (truth.isEmpty() && found.isEmpty()) {
+        return 1;
+    }
+    QList<bool> used;
+    for (int i = 0; i < found.size(); i++) {
+        used.append(false);
+    }
+    qreal sum = 0;
+    for (int i = 0; i < truth.size(); i++) {
+        qreal best = 0;
+        int bestIndex = -1;
+        for (int j = 0; j < found.size(); j++) {
+            qreal iou = intersectionOverUnion(truth.at(i), found.at(j));
+            if (!used.at(j) && (iou > best)) {
+                best = iou;
+                bestIndex = j;
+            }
+        }
+        if (bestIndex >= 0) {
+            used[bestIndex] = true;
+        }
+        sum += best;
+    }
+    int unmatched = used.count(false);
+    return sum / (truth.size() + unmatched);
+}
+
+static QJsonArray rectsToJson(const QList<QRectF> &rects)
+{
+    QJsonArray array;
+    for (int i = 0; i < rects.size(); i++) {
+        QJsonArray rect;
+        rect.append(rects.at(i).left());
+        rect.append(rects.at(i).top());
+        rect.append(rects.at(i).right());
+        rect.append(rects.at(i).bottom());
+        array.append(rect);
+    }
+    return array;
+}
+
+static void printJson(const QJsonObject &obj)
+{
+    fprintf(stdout, "%s\n", QJsonDocument(obj).toJson(QJsonDocument::Compact).constData());
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    if ((argc < 2) || (argc > 4)) {
+        qDebug() << "Usage: selectionbenchmark <directory> [iterations] [area]";
+        return 1;
+    }
+
+    QDir dir(QString::fromUtf8(argv[1]));
+    int iterations = (argc > 2) ? QString::fromUtf8(argv[2]).toInt() : 1;
+    float area = (argc > 3) ? QString::fromUtf8(argv[3]).toFloat() : 10000.0;
+    if (!dir.exists() || (iterations < 1) || (area <= 0)) {
+        qDebug() << "Invalid arguments";
+        return 1;
+    }
+
+    QStringList filters;
+    QList<QByteArray> formats = QImageReader::supportedImageFormats();
+    for (int i = 0; i < formats.size(); i++) {
+        filters << QStringLiteral("*.") + QString::fromLatin1(formats.at(i));
+    }
+    QFileInfoList files = dir.entryInfoList(filters, QDir::Files, QDir::Name);
+
+    qint64 totalDetectNs = 0;
+    qint64 totalRefineNs = 0;
+    qreal totalIoU = 0;
+    int numImages = 0;
+
+    for (int i = 0; i < files.size(); i++) {
+        QImage img(files.at(i).filePath());
+        if (img.isNull()) {
+            qDebug() << "Could not load" << files.at(i).filePath();
+            continue;
+        }
+        QList<QRectF> truth = readGroundTruth(files.at(i).dir().filePath(files.at(i).completeBaseName() + QStringLiteral(".txt")));
+
+        QList<QRectF> selections;
+        qint64 detectNs = 0;
+        qint64 refineNs = 0;
+        QElapsedTimer timer;
+        for (int iter = 0; iter < iterations; iter++) {
+            int pixelMargin;
+            timer.start();
+            selections = KSaneSelectionFinder::detectSelections(img, area, pixelMargin);
+            detectNs += timer.nsecsElapsed();
+
+            timer.start();
+            KSaneSelectionFinder::refineSelections(img, selections, pixelMargin);
+            refineNs += timer.nsecsElapsed();
+        }
+        KSaneSelectionFinder::removeSmallSelections(img, selections);
+
+        qreal iou = meanIoU(truth, selections);
+
+        QJsonObject result;
+        result.insert(QStringLiteral("image"), files.at(i).fileName());
+        result.insert(QStringLiteral("width"), img.width());
+        result.insert(QStringLiteral("height"), img.height());
+        result.insert(QStringLiteral("detectMs"), (detectNs / iterations) / 1000000.0);
+        result.insert(QStringLiteral("refineMs"), (refineNs / iterations) / 1000000.0);
+        result.insert(QStringLiteral("expected"), rectsToJson(truth));
+        result.insert(QStringLiteral("found"), rectsToJson(selections));
+        result.insert(QStringLiteral("iou"), iou);
+        printJson(result);
+
+        totalDetectNs += detectNs / iterations;
+        totalRefineNs += refineNs / iterations;
+        totalIoU += iou;
+        numImages++;
+    }
+
+    QJsonObject summary;
+    summary.insert(QStringLiteral("images"), numImages);
+    summary.insert(QStringLiteral("iterations"), iterations);
+    summary.insert(QStringLiteral("area"), area);
+    summary.insert(QStringLiteral("detectMs"), totalDetectNs / 1000000.0);
+    summary.insert(QStringLiteral("refineMs"), totalRefineNs / 1000000.0);
+    summary.insert(QStringLiteral("meanIoU"), (numImages > 0) ? totalIoU / numImages : 0.0);
+    printJson(summary);
+
+    return (numImages > 0) ? 0 : 1;
+}